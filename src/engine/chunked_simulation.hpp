@@ -0,0 +1,124 @@
+#ifndef CHUNKED_SIMULATION_HPP
+#define CHUNKED_SIMULATION_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "cpu_timing.hpp"
+#include "functional_cache.hpp"
+#include "parallel_simulation.hpp"
+#include "../helper_structs/request.h"
+#include "../helper_structs/result.h"
+
+/* Time-parallel simulation.
+ *
+ * The timed requests are split into contiguous chunks that are simulated on their own
+ * threads, each on a FunctionalCache that starts cold and is warmed up on the chunkWarmup
+ * requests before the chunk. The first chunk continues the --warmup requests like the
+ * serial simulation. The requests that fetched lines are concatenated in trace order and
+ * replayed with CpuTiming, so the cycle limit applies to the stitched trace.
+ *
+ * Only the first requests of later chunks can differ from a serial run, where the short
+ * warm-up doesn't restore the whole cache state. To estimate that error, a prefix of the
+ * trace with the same number of chunks (each twice as long as the warm-up) is simulated
+ * chunked and serially. Both have the same number of chunk borders, so the differences of
+ * hits, misses and cycles on the prefix are the estimate for the whole trace. */
+
+// Chunks of the validation prefix are at least this long, so they have history before their warm-up
+const size_t minValidationChunk = 1024;
+
+/* Requests of [first, last) that fetched lines, split into chunks simulated in parallel.
+ * The first chunk is warmed up from warmupStart, every other one on its chunkWarmup preceding requests. */
+template<typename Cache>
+inline std::vector<ShardMiss> simulateChunks(bool directMapped, unsigned offsetBitsCount, uint32_t numberOfSets,
+                                             const Request* requests, size_t warmupStart, size_t first, size_t last,
+                                             unsigned chunks, size_t chunkWarmup) {
+    std::vector<std::vector<ShardMiss>> chunkMisses(chunks);
+    std::vector<std::thread> workers;
+    size_t length = last - first;
+
+    for(unsigned chunk = 0; chunk < chunks; ++chunk) {
+        workers.emplace_back([&, chunk]() {
+            size_t start = first + length * chunk / chunks;
+            size_t end = first + length * (chunk + 1) / chunks;
+            size_t warmup = chunk == 0 ? warmupStart : start - std::min(start, chunkWarmup);
+            Cache cache(directMapped, offsetBitsCount, numberOfSets);
+
+            for(size_t i = warmup; i < start; ++i) {
+                cache.accessRequest(requests[i]);
+            }
+            for(size_t i = start; i < end; ++i) {
+                unsigned fetchedLines = cache.accessRequest(requests[i]);
+                if(fetchedLines > 0) {
+                    chunkMisses[chunk].push_back(ShardMiss {i, fetchedLines});
+                }
+            }
+        });
+    }
+    for(std::thread& worker : workers) {
+        worker.join();
+    }
+
+    // Chunks are contiguous, so appending them keeps the trace order
+    std::vector<ShardMiss> misses = std::move(chunkMisses[0]);
+    for(unsigned chunk = 1; chunk < chunks; ++chunk) {
+        misses.insert(misses.end(), chunkMisses[chunk].begin(), chunkMisses[chunk].end());
+    }
+    return misses;
+}
+
+// Replays the timing of the requests [first, last) of which only misses fetched lines
+inline CpuTiming replayChunks(CpuTiming timing, const Request* requests, const std::vector<ShardMiss>& misses,
+                              size_t first, size_t last) {
+    size_t nextRequest = first;
+    for(const ShardMiss& miss : misses) {
+        if(!timing.finished) {
+            break;
+        }
+        // All requests in between were hits
+        timing.addRequests(requests + nextRequest, miss.request - nextRequest, 0);
+        timing.addRequests(requests + miss.request, 1, miss.fetchedLines);
+        nextRequest = miss.request + 1;
+    }
+    timing.addRequests(requests + nextRequest, last - nextRequest, 0);
+    return timing;
+}
+
+inline double absoluteDifference(size_t a, size_t b) {
+    return a > b ? (double)(a - b) : (double)(b - a);
+}
+
+template<typename Cache = FunctionalCache>
+inline Result runChunkedSimulation(int cycles, bool directMapped, unsigned offsetBitsCount, uint32_t numberOfSets,
+                                   unsigned cacheLatency, unsigned memoryLatency, size_t numRequests,
+                                   const Request* requests, size_t warmupCount, unsigned chunks, size_t chunkWarmup) {
+    CpuTiming timing(cycles, cacheLatency, memoryLatency);
+    std::vector<ShardMiss> misses = simulateChunks<Cache>(directMapped, offsetBitsCount, numberOfSets, requests,
+                                                   0, warmupCount, numRequests, chunks, chunkWarmup);
+    Result result = replayChunks(timing, requests, misses, warmupCount, numRequests).result();
+    result.sampledRequests = numRequests - warmupCount;
+    result.timedRequests = numRequests - warmupCount;
+
+    // Validation without cycle limit, so both runs account every request of the prefix
+    size_t validationChunk = std::max(2 * chunkWarmup, minValidationChunk);
+    size_t validationEnd = warmupCount + std::min(numRequests - warmupCount, validationChunk * chunks);
+    CpuTiming unlimited(cycles, cacheLatency, memoryLatency);
+    unlimited.maxCycles = SIZE_MAX;
+
+    CpuTiming chunked = replayChunks(unlimited, requests, simulateChunks<Cache>(directMapped, offsetBitsCount, numberOfSets, requests,
+                                                                         0, warmupCount, validationEnd, chunks, chunkWarmup),
+                                     warmupCount, validationEnd);
+    CpuTiming serial = replayChunks(unlimited, requests, simulateChunks<Cache>(directMapped, offsetBitsCount, numberOfSets, requests,
+                                                                        0, warmupCount, validationEnd, 1, 0),
+                                    warmupCount, validationEnd);
+
+    result.validatedRequests = validationEnd - warmupCount;
+    result.cyclesMargin = absoluteDifference(chunked.elapsedCycles, serial.elapsedCycles);
+    result.missesMargin = absoluteDifference(chunked.misses, serial.misses);
+    result.hitsMargin = absoluteDifference(chunked.hits, serial.hits);
+    return result;
+}
+
+#endif
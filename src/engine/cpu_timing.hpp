@@ -0,0 +1,56 @@
+#ifndef CPU_TIMING_HPP
+#define CPU_TIMING_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+#include "../helper_structs/request.h"
+#include "../helper_structs/result.h"
+
+/* Replays the timing of the CPU module for the engines without SystemC.
+ * A request takes the compute cycles of its gap and then cacheLatency + memoryLatency
+ * per fetched line, but at least one clock cycle because the CPU only sends a request
+ * on a rising edge. Requests are only counted if they finish within maxCycles,
+ * otherwise the result cycles are SIZE_MAX. */
+struct CpuTiming {
+    size_t maxCycles;
+    unsigned cacheLatency, memoryLatency;
+
+    size_t elapsedCycles = 0, hits = 0, misses = 0;
+    bool finished = true;
+
+    // Same conversion of the cycle limit as in the CPU module
+    CpuTiming(int cycles, unsigned cacheLatency, unsigned memoryLatency) :
+    maxCycles(cycles), cacheLatency(cacheLatency), memoryLatency(memoryLatency) {}
+
+    // Accounts count consecutive requests from first on that each fetched fetchedLines lines
+    void addRequests(const Request* first, size_t count, unsigned fetchedLines) {
+        if(!finished || count == 0) {
+            return;
+        }
+
+        size_t latency = std::max<size_t>((size_t)cacheLatency + (size_t)memoryLatency * fetchedLines, 1);
+        size_t completed = 0;
+        for(; completed < count; ++completed) {
+            size_t requestCycles = latency + first[completed].gap;
+            if(requestCycles > maxCycles - elapsedCycles) {
+                break;
+            }
+            elapsedCycles += requestCycles;
+        }
+
+        (fetchedLines == 0 ? hits : misses) += completed;
+        finished = completed == count;
+    }
+
+    Result result() const {
+        Result result = {};
+        result.cycles = finished ? elapsedCycles : SIZE_MAX;
+        result.hits = hits;
+        result.misses = misses;
+        return result;
+    }
+};
+
+#endif
@@ -0,0 +1,103 @@
+#ifndef FUNCTIONAL_CACHE_HPP
+#define FUNCTIONAL_CACHE_HPP
+
+#include <cstdint>
+#include <vector>
+
+#include "../helper_structs/request.h"
+#include "../utils/tag_probe.hpp"
+#include "../utils/fast_divider.hpp"
+
+/* Tag-only model of DIRECT_MAPPED_CACHE and FOURWAY_CACHE without SystemC.
+ * It takes the same hit/miss decisions byte by byte and in the same byte order
+ * as the modules, but keeps neither line data nor main memory and doesn't
+ * simulate time. A direct-mapped cache is handled as a FIFO cache with one way.
+ *
+ * Address is the width of addresses and tags: FunctionalCache keeps the 32-bit tags and
+ * tag probes of 32-bit traces, WideFunctionalCache is only needed above 4 GB. */
+template<typename Address>
+struct BasicFunctionalCache {
+    typedef Address Tag;
+
+    BasicFunctionalCache(bool directMapped, unsigned offsetBitsCount, uint32_t numberOfSets) :
+    directMapped(directMapped), ways(directMapped ? 1 : 4),
+    offsetBitsCount(offsetBitsCount), sets(numberOfSets),
+    tags((size_t)ways * numberOfSets), used(numberOfSets), oldest(numberOfSets) {}
+
+    // Set and tag are remainder and quotient of the line address, bit slices for a power of 2
+    uint32_t setIndex(Address address) const {
+        return (uint32_t)sets.remainder((Address)(address >> offsetBitsCount));
+    }
+
+    Address tag(Address address) const {
+        return sets.quotient((Address)(address >> offsetBitsCount));
+    }
+
+    /* Accesses one byte and fetches its line on a miss.
+     * Returns true if the line had to be fetched from main memory. */
+    bool accessByte(Address address) {
+        return accessLine(setIndex(address), tag(address));
+    }
+
+    // Same as accessByte() for an address that is already split into set index and tag
+    bool accessLine(uint32_t set, Address tag) {
+        Address* lines = &tags[(size_t)set * ways];
+
+        // Until a set is full its valid lines are the first ways
+        if(ways >= 4) {
+            uint32_t validMask = used[set] >= 32 ? 0xFFFFFFFF : (1u << used[set]) - 1;
+            if(findWay(lines, ways, validMask, tag) >= 0) {
+                return false;
+            }
+        } else {
+            for(unsigned i = 0; i < used[set]; ++i) {
+                if(lines[i] == tag) {
+                    return false;
+                }
+            }
+        }
+
+        // FIFO replacement: a full set overwrites its oldest line
+        if(used[set] < ways) {
+            lines[(oldest[set] + used[set]++) % ways] = tag;
+        } else {
+            lines[oldest[set]] = tag;
+            oldest[set] = (oldest[set] + 1) % ways;
+        }
+        return true;
+    }
+
+    /* Accesses the bytes of a request whose set is accepted by inShard and returns
+     * the number of fetched lines. The four-way cache reads the bytes backwards. */
+    template<typename ShardFilter>
+    unsigned accessRequest(const Request& request, ShardFilter inShard) {
+        unsigned fetchedLines = 0;
+        unsigned size = request_size(&request);
+        for(unsigned i = 0; i < size; ++i) {
+            Address address = (Address)(request.addr + (request.we || directMapped ? i : size - 1 - i));
+            if(inShard(setIndex(address))) {
+                fetchedLines += accessByte(address);
+            }
+        }
+        return fetchedLines;
+    }
+
+    unsigned accessRequest(const Request& request) {
+        return accessRequest(request, [](uint32_t) { return true; });
+    }
+
+    bool directMapped;
+    unsigned ways;
+    unsigned offsetBitsCount;
+    FastDivider sets;
+
+    // tags of all ways of a set lie next to each other, so a four-way set fills one aligned 16 byte block
+    std::vector<Address> tags;
+    // number of valid lines and position of the oldest line of every set
+    std::vector<uint8_t> used, oldest;
+};
+
+typedef BasicFunctionalCache<uint32_t> FunctionalCache;
+typedef BasicFunctionalCache<uint64_t> WideFunctionalCache;
+
+#endif
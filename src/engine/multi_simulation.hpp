@@ -0,0 +1,84 @@
+#ifndef MULTI_SIMULATION_HPP
+#define MULTI_SIMULATION_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "cpu_timing.hpp"
+#include "functional_cache.hpp"
+#include "../helper_structs/request.h"
+#include "../helper_structs/result.h"
+
+/* Simulates several caches in a single pass over the trace.
+ *
+ * Caches with the same line size and number of sets share the address decode:
+ * set index and tag of the bytes of a request are computed once per geometry
+ * and every cache of that geometry only does its lookup. The timing of every cache
+ * is replayed like in the CPU module. */
+template<typename Cache>
+inline std::vector<Result> runMultiSimulation(int cycles, unsigned cacheLatency, unsigned memoryLatency,
+                                              size_t numRequests, const Request* requests, size_t warmupCount,
+                                              std::vector<Cache>& caches) {
+    // Caches grouped by geometry, the first cache of a group does the decoding
+    std::vector<std::vector<size_t>> geometries;
+    for(size_t c = 0; c < caches.size(); ++c) {
+        bool found = false;
+        for(std::vector<size_t>& geometry : geometries) {
+            const Cache& first = caches[geometry[0]];
+            if(first.offsetBitsCount == caches[c].offsetBitsCount && first.sets.divisor == caches[c].sets.divisor) {
+                geometry.push_back(c);
+                found = true;
+                break;
+            }
+        }
+        if(!found) {
+            geometries.push_back(std::vector<size_t>(1, c));
+        }
+    }
+
+    std::vector<CpuTiming> timings(caches.size(), CpuTiming(cycles, cacheLatency, memoryLatency));
+    uint32_t sets[64];
+    typename Cache::Tag tags[64];
+
+    for(size_t i = 0; i < numRequests; ++i) {
+        const Request& request = requests[i];
+        unsigned size = std::min(request_size(&request), 64u);
+
+        for(const std::vector<size_t>& geometry : geometries) {
+            const Cache& decoder = caches[geometry[0]];
+            for(unsigned k = 0; k < size; ++k) {
+                sets[k] = decoder.setIndex(request.addr + k);
+                tags[k] = decoder.tag(request.addr + k);
+            }
+
+            for(size_t c : geometry) {
+                Cache& cache = caches[c];
+                unsigned fetchedLines = 0;
+
+                // The four-way cache reads the bytes backwards
+                bool forward = request.we || cache.directMapped;
+                for(unsigned k = 0; k < size; ++k) {
+                    unsigned byte = forward ? k : size - 1 - k;
+                    fetchedLines += cache.accessLine(sets[byte], tags[byte]);
+                }
+
+                // Warm-up requests only change the cache state
+                if(i >= warmupCount) {
+                    timings[c].addRequests(&request, 1, fetchedLines);
+                }
+            }
+        }
+    }
+
+    std::vector<Result> results;
+    for(const CpuTiming& timing : timings) {
+        results.push_back(timing.result());
+        results.back().sampledRequests = numRequests - warmupCount;
+        results.back().timedRequests = numRequests - warmupCount;
+    }
+    return results;
+}
+
+#endif
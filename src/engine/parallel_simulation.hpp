@@ -0,0 +1,149 @@
+#ifndef PARALLEL_SIMULATION_HPP
+#define PARALLEL_SIMULATION_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <queue>
+#include <thread>
+#include <vector>
+
+#include "cpu_timing.hpp"
+#include "functional_cache.hpp"
+#include "../helper_structs/request.h"
+#include "../helper_structs/result.h"
+
+/* Set-partitioned parallel simulation.
+ *
+ * Cache sets never influence each other, so every worker simulates only the sets
+ * with setIndex % threads == worker on its own FunctionalCache, which only holds
+ * the tags of these sets. The trace is decoded once into a shard per worker:
+ * every thread splits a contiguous part of the trace into the lines its requests touch,
+ * then every worker walks its shard of all parts in trace order. A request crossing
+ * a line border may touch sets of several workers; its fetched lines are the sum over all workers.
+ *
+ * The workers only record the requests that fetched lines. These lists are merged
+ * back in trace order to replay the timing of the CPU module with CpuTiming. */
+
+// Lines one worker fetched for one request
+struct ShardMiss {
+    size_t request;
+    unsigned fetchedLines;
+};
+
+/* A line a request touches in the sets of one worker, with the set index within the worker.
+ * The bytes of a request in one line are a single access, only the first can miss. */
+template<typename Tag>
+struct ShardAccess {
+    size_t request;
+    uint32_t set;
+    Tag tag;
+};
+
+template<typename Cache = FunctionalCache>
+inline Result runParallelSimulation(int cycles, bool directMapped, unsigned offsetBitsCount, uint32_t numberOfSets,
+                                    unsigned cacheLatency, unsigned memoryLatency, size_t numRequests,
+                                    const Request* requests, size_t warmupCount, unsigned threads) {
+    typedef typename Cache::Tag Tag;
+    typedef std::vector<ShardAccess<Tag>> Shard;
+
+    // shards[part][worker]: the accesses of a contiguous part of the trace to the sets of a worker
+    std::vector<std::vector<Shard>> shards(threads, std::vector<Shard>(threads));
+    std::vector<std::vector<ShardMiss>> shardMisses(threads);
+    std::vector<std::thread> workers;
+
+    // Set and tag of a line like Cache::setIndex() and Cache::tag()
+    const FastDivider sets(numberOfSets);
+
+    for(unsigned part = 0; part < threads; ++part) {
+        workers.emplace_back([&, part]() {
+            size_t first = numRequests * part / threads, last = numRequests * (part + 1) / threads;
+            for(size_t i = first; i < last; ++i) {
+                const Request& request = requests[i];
+                unsigned size = request_size(&request);
+                Tag firstLine = (Tag)request.addr >> offsetBitsCount;
+                Tag lastLine = (Tag)(request.addr + size - 1) >> offsetBitsCount;
+                Tag lines = lastLine - firstLine + 1;
+
+                // The four-way cache reads the bytes backwards
+                bool forward = request.we || directMapped;
+                for(Tag k = 0; k < lines; ++k) {
+                    Tag line = forward ? firstLine + k : lastLine - k;
+                    uint32_t set = (uint32_t)sets.remainder(line);
+                    shards[part][set % threads].push_back(ShardAccess<Tag> {i, set / threads, sets.quotient(line)});
+                }
+            }
+        });
+    }
+    for(std::thread& worker : workers) {
+        worker.join();
+    }
+    workers.clear();
+
+    for(unsigned worker = 0; worker < threads; ++worker) {
+        workers.emplace_back([&, worker]() {
+            // The sets worker, worker + threads, ... are stored next to each other
+            uint32_t workerSets = numberOfSets > worker ? (numberOfSets - worker + threads - 1) / threads : 1;
+            Cache cache(directMapped, offsetBitsCount, workerSets);
+            std::vector<ShardMiss>& misses = shardMisses[worker];
+
+            for(unsigned part = 0; part < threads; ++part) {
+                for(const ShardAccess<Tag>& access : shards[part][worker]) {
+                    // warm-up requests only change the cache state
+                    if(cache.accessLine(access.set, access.tag) && access.request >= warmupCount) {
+                        if(!misses.empty() && misses.back().request == access.request) {
+                            ++misses.back().fetchedLines;
+                        } else {
+                            misses.push_back(ShardMiss {access.request, 1});
+                        }
+                    }
+                }
+                // Each part is only walked once
+                Shard().swap(shards[part][worker]);
+            }
+        });
+    }
+    for(std::thread& worker : workers) {
+        worker.join();
+    }
+
+    CpuTiming timing(cycles, cacheLatency, memoryLatency);
+
+    // k-way merge of the sorted miss lists, the smallest request index first
+    typedef std::pair<size_t, unsigned> Head; // request index, worker
+    std::priority_queue<Head, std::vector<Head>, std::greater<Head>> heads;
+    std::vector<size_t> positions(threads, 0);
+    for(unsigned worker = 0; worker < threads; ++worker) {
+        if(!shardMisses[worker].empty()) {
+            heads.push(Head(shardMisses[worker][0].request, worker));
+        }
+    }
+
+    size_t nextRequest = warmupCount;
+    while(!heads.empty() && timing.finished) {
+        size_t request = heads.top().first;
+        unsigned fetchedLines = 0;
+
+        // Collecting the lines all workers fetched for this request
+        while(!heads.empty() && heads.top().first == request) {
+            unsigned worker = heads.top().second;
+            heads.pop();
+            fetchedLines += shardMisses[worker][positions[worker]++].fetchedLines;
+            if(positions[worker] < shardMisses[worker].size()) {
+                heads.push(Head(shardMisses[worker][positions[worker]].request, worker));
+            }
+        }
+
+        // All requests in between were hits
+        timing.addRequests(requests + nextRequest, request - nextRequest, 0);
+        timing.addRequests(requests + request, 1, fetchedLines);
+        nextRequest = request + 1;
+    }
+    timing.addRequests(requests + nextRequest, numRequests - nextRequest, 0);
+
+    Result result = timing.result();
+    result.sampledRequests = numRequests - warmupCount;
+    result.timedRequests = numRequests - warmupCount;
+    return result;
+}
+
+#endif
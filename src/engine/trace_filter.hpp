@@ -0,0 +1,101 @@
+#ifndef TRACE_FILTER_HPP
+#define TRACE_FILTER_HPP
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+
+#include "functional_cache.hpp"
+#include "../helper_structs/request.h"
+
+/* Filtered trace: only the requests a cache sends to the next level, in the trace format, so a
+ * lower level can be studied without replaying every request of the level above.
+ *
+ * Every fetched line becomes a read of the whole line (in 64 byte pieces for longer lines) and
+ * every store, which the write-through caches pass on, a write with its data. The gap column
+ * holds the cycles the cache spent since the previous filtered request without the main memory
+ * latency, which the next level replaces: compute gaps and cache latencies. A comment behind
+ * every line gives the index of the original request and the cycle it started at with the flat
+ * memory latency. */
+
+// Statistics of a filtered trace
+struct TraceFilterResult {
+    // false if the file couldn't be written
+    bool written = false;
+    // filtered requests and those of them coming from the --warmup requests, which are written first
+    size_t requests = 0;
+    size_t warmupRequests = 0;
+};
+
+template<typename Cache = FunctionalCache>
+inline TraceFilterResult writeFilteredTrace(const char* filename, bool directMapped, unsigned cacheLines,
+                                            unsigned cacheLineSize, unsigned cacheLatency, unsigned memoryLatency,
+                                            const Request* requests, size_t numRequests, size_t warmupCount) {
+    unsigned offsetBitsCount = 0;
+    while((1u << offsetBitsCount) < cacheLineSize) {
+        ++offsetBitsCount;
+    }
+    Cache cache(directMapped, offsetBitsCount, directMapped ? cacheLines : cacheLines / 4);
+
+    TraceFilterResult result;
+    std::ofstream out(filename);
+    char line[128];
+
+    snprintf(line, sizeof(line), "# filtered by a %s cache of %u lines of %u bytes: <request> <cycle>\n",
+             directMapped ? "directmapped" : "fourway", cacheLines, cacheLineSize);
+    out << line;
+
+    // Cycle of the flat memory latency timeline and the cache cycles since the last filtered request
+    size_t cycle = 0, pendingGap = 0;
+    auto emit = [&](char operation, uint64_t address, uint32_t data, unsigned size, unsigned stream, size_t request) {
+        if(operation == 'w') {
+            snprintf(line, sizeof(line), "w,0x%08" PRIx64 ",0x%" PRIx32 ",%u,%zu,%u # %zu %zu\n",
+                     address, data, size, pendingGap, stream, request, cycle);
+        } else {
+            snprintf(line, sizeof(line), "r,0x%08" PRIx64 ",,%u,%zu,%u # %zu %zu\n",
+                     address, size, pendingGap, stream, request, cycle);
+        }
+        out << line;
+        pendingGap = 0;
+        result.requests++;
+    };
+
+    for(size_t i = 0; i < numRequests; ++i) {
+        const Request& request = requests[i];
+        unsigned size = request_size(&request);
+        cycle += request.gap;
+        pendingGap += request.gap;
+
+        // The write-through store reaches the next level right away
+        if(request.we) {
+            emit('w', request.addr, request.data, size, request.stream, i);
+        }
+
+        // Byte order of the modules, every fetched line is read in pieces the trace format allows
+        unsigned fetchedLines = 0;
+        for(unsigned k = 0; k < size; ++k) {
+            uint64_t address = request.addr + (request.we || directMapped ? k : size - 1 - k);
+            if(cache.accessByte(address)) {
+                uint64_t lineAddress = address & ~(uint64_t)(cacheLineSize - 1);
+                for(unsigned piece = 0; piece < cacheLineSize; piece += 64) {
+                    emit('r', lineAddress + piece, 0, std::min(cacheLineSize, 64u), request.stream, i);
+                }
+                ++fetchedLines;
+            }
+        }
+
+        cycle += std::max<size_t>((size_t)cacheLatency + (size_t)memoryLatency * fetchedLines, 1);
+        pendingGap += cacheLatency;
+
+        if(i + 1 == warmupCount) {
+            result.warmupRequests = result.requests;
+        }
+    }
+
+    result.written = (bool)out;
+    return result;
+}
+
+#endif
@@ -0,0 +1,11 @@
+#ifndef CACHE_CONFIG_H
+#define CACHE_CONFIG_H
+
+// Geometry of one cache in a multi-configuration run
+struct CacheConfig {
+    int directMapped;
+    unsigned cacheLines;
+    unsigned cacheLineSize;
+};
+
+#endif
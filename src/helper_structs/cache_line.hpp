@@ -1,9 +1,13 @@
 #ifndef CACHE_LINE_HPP
 #define CACHE_LINE_HPP
 
+// Tag has the width of the addresses, 32 bits unless the trace has wider ones
+template<typename Tag>
 struct CacheLine {
-    unsigned tag = 0;
+    Tag tag = 0;
     bool valid = false;
+    // bit s is set while sector s of a sectored line hasn't been fetched yet, 0 for a complete line
+    uint64_t missingSectors = 0;
     std::map<uint32_t, uint8_t> data;
 };
 
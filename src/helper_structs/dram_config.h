@@ -0,0 +1,33 @@
+#ifndef DRAM_CONFIG_H
+#define DRAM_CONFIG_H
+
+// Order of the address bits that select channel, rank, bank and row of a main memory access
+enum DramMapping {
+    // row:channel:rank:bank:column, consecutive lines stay in the same row
+    DRAM_MAPPING_PAGE,
+    // row:column:channel:rank:bank:line offset, consecutive lines go to different banks
+    DRAM_MAPPING_LINE,
+    // like DRAM_MAPPING_PAGE with the bank bits XORed with the lowest row bits against bank conflicts
+    DRAM_MAPPING_XOR
+};
+
+// Main memory organisation and row buffer latencies for the DRAM timing model
+struct DramConfig {
+    // all powers of 2
+    unsigned channels;
+    unsigned ranks;
+    unsigned banks;
+    // bytes in the row buffer of one bank
+    unsigned rowSize;
+
+    // cycles for fetching a line when its row is already open, no row is open or another row is open
+    unsigned rowHitLatency;
+    unsigned rowMissLatency;
+    unsigned rowConflictLatency;
+
+    // close the row after every access instead of keeping it open for following accesses
+    int closedPage;
+    enum DramMapping mapping;
+};
+
+#endif
@@ -0,0 +1,23 @@
+#ifndef FOUR_WAY_SET_HPP
+#define FOUR_WAY_SET_HPP
+
+#include <cstddef>
+
+#include "cache_line.hpp"
+
+/* One set of the four-way cache. The tags are kept next to each other in one
+ * aligned block so that all ways can be compared at once, 16 bytes for 32-bit tags.
+ * A line stays in its way until it is replaced, the FIFO order is given by the oldest way. */
+template<typename Tag>
+struct FourWaySet {
+    alignas(4 * sizeof(Tag)) Tag tags[4] = {0, 0, 0, 0};
+    // Number of valid ways. Until the set is full these are the first ways.
+    uint8_t used = 0;
+    // Way that is replaced next once the set is full
+    uint8_t oldest = 0;
+    // Insertion order of every way, only used by the skewed mapping where the ways of a line lie in different sets
+    size_t insertedAt[4] = {0, 0, 0, 0};
+    CacheLine<Tag> lines[4];
+};
+
+#endif
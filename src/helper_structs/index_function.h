@@ -0,0 +1,16 @@
+#ifndef INDEX_FUNCTION_H
+#define INDEX_FUNCTION_H
+
+// How the set of a cache line is selected from its address
+enum IndexFunction {
+    // the index bits right above the offset, power of 2 strides all go to the same set
+    INDEX_BITSLICE,
+    // the index bits XORed with every following slice of the same width up to the top of the address
+    INDEX_XOR,
+    // line address modulo the largest prime not above the number of sets, the remaining sets stay unused
+    INDEX_PRIME,
+    // four-way only: every way has its own hash, the index bits rotated by the way XORed with the next slice
+    INDEX_SKEWED
+};
+
+#endif
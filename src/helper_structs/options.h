@@ -0,0 +1,82 @@
+#ifndef OPTIONS_H
+#define OPTIONS_H
+
+#include "cache_config.h"
+#include "dram_config.h"
+#include "index_function.h"
+#include "tlb_config.h"
+
+/* Optional simulation features that go beyond the basic cache parameters.
+ * A zeroed struct means every feature is switched off. */
+struct SimulationOptions {
+    // Simulate only 1/sampleRate of the sets and extrapolate the result (0 or 1 = all sets)
+    unsigned sampleRate;
+
+    // Snapshot file to warm-start the cache and main memory from (NULL = cold start)
+    const char* loadStateFile;
+    // Snapshot file the final cache and main memory state is written to (NULL = not saved)
+    const char* saveStateFile;
+
+    // Number of requests at the start of the trace that only warm up the cache without timing or statistics
+    unsigned warmupRequests;
+
+    /* Number of threads for the set-partitioned simulation without SystemC (0 or 1 = SystemC model).
+     * Only hits, misses and cycles are simulated, read data isn't written back to the requests. */
+    unsigned threads;
+
+    /* Number of contiguous chunks of the trace simulated in parallel without SystemC (0 or 1 = no chunks).
+     * Every chunk starts cold and is warmed up on its chunkWarmup preceding requests. */
+    unsigned chunks;
+    unsigned chunkWarmup;
+
+    // Use the loosely-timed TLM-2.0 modules instead of the pin-level ones (0 = pin-level)
+    int tlm;
+    // Global quantum in cycles the TLM CPU may run ahead of the simulation time
+    unsigned quantum;
+
+    // Row buffer timing of main memory instead of memoryLatency for every fetched line (NULL = flat latency)
+    const struct DramConfig* dram;
+
+    // Bytes the memory bus transfers per cycle, line fills and stores queue for it (0 = unlimited bandwidth)
+    unsigned busBytesPerCycle;
+
+    /* Timing only: the cache keeps tags and replacement state, main memory isn't modelled
+     * and read data isn't written back to the requests (0 = full data) */
+    int noData;
+
+    // Function that selects the set of an address in the SystemC caches (zeroed = INDEX_BITSLICE)
+    enum IndexFunction indexFunction;
+
+    // Bytes of a sector with their own valid bit, a miss only fetches the missing sector (0 = whole lines)
+    unsigned sectorSize;
+
+    // Geometry of a separate L1 instruction cache for the fetches, requires tlm (NULL = unified L1)
+    const struct CacheConfig* instructionCache;
+
+    // Geometry of a unified cache between the L1 caches and main memory (NULL = no lower level)
+    const struct CacheConfig* lowerLevel;
+    // Cycles a lower level lookup adds to every L1 fetch
+    unsigned lowerLevelLatency;
+
+    // Virtual addresses translated by TLBs and page table walks ahead of the cache (NULL = physical addresses)
+    const struct TlbConfig* tlb;
+
+    /* Ways of the four-way caches every stream may fill on a miss, MAX_STREAMS masks of 4 bits
+     * indexed by stream where 0 allows all ways (NULL = no partitioning) */
+    const unsigned* wayMasks;
+
+    /* Length of the intervals whose hits, misses, cycles, evictions and occupancy of the (data) cache are
+     * written to intervalFile while the SystemC caches run, in requests or with intervalInCycles in cycles
+     * (0 = no interval statistics) */
+    unsigned interval;
+    int intervalInCycles;
+    // CSV file of the interval statistics, a JSON array with intervalJson
+    const char* intervalFile;
+    int intervalJson;
+
+    /* Address width of the simulated hardware: 32, 48 or 64 bits (0 = 32). It sizes the tags, comparators
+     * and TLB entries, the trace has to fit into it. Above 32 bits the engines and cache models keep 64-bit tags. */
+    unsigned addressBits;
+};
+
+#endif
@@ -1,11 +1,69 @@
 #ifndef REQUEST_H
 #define REQUEST_H
 
+#include <stddef.h>
+#include <stdint.h>
+
+// Streams a trace can distinguish, their IDs are 0 to MAX_STREAMS - 1
+#define MAX_STREAMS 256u
+
 struct Request {
-    uint32_t addr;
+    // virtual or physical byte address, 64-bit processes use up to 47 bits
+    uint64_t addr;
     uint32_t data;
     int we;
 
+    /* Bytes accessed from addr on: 1, 2, 4, 8, 16, 32 or 64 (0 = 4 like before sizes were supported).
+     * data is the value of the accessed bytes, most significant byte at addr. Wider reads give back
+     * their lowest 4 bytes. Wider stores have no value (data is 0), they need a simulation without data. */
+    unsigned size;
+
+    // Instruction fetch: a read that goes to the instruction cache of a split L1, otherwise like any read
+    int fetch;
+
+    // Compute cycles between the end of the previous request and this one, the CPU idles for them
+    uint32_t gap;
+
+    // Stream (tenant) that issued the request, selects its ways of a partitioned cache and its statistics
+    unsigned stream;
 };
 
+// Bytes accessed by request
+static inline unsigned request_size(const struct Request *request) {
+    return request->size != 0 ? request->size : 4;
+}
+
+// Position of byte i of an access of size bytes within data, 32 or more if it lies above data
+static inline unsigned access_byte_shift(unsigned size, unsigned i) {
+    return 8 * (size - 1 - i);
+}
+
+/* Address width a trace needs: 32, 48 for the virtual addresses of 64-bit processes or 64 bits.
+ * A trace has to fit into the address width of the simulated cache. */
+static inline unsigned requests_address_bits(const struct Request *requests, size_t numRequests) {
+    uint64_t highest = 0;
+    for (size_t i = 0; i < numRequests; i++) {
+        uint64_t last = requests[i].addr + (request_size(&requests[i]) - 1);
+        highest |= last < requests[i].addr ? UINT64_MAX : last;
+    }
+    return highest <= UINT32_MAX ? 32 : highest <= 0xFFFFFFFFFFFFull ? 48 : 64;
+}
+
+/* Index of the first store wider than the 4 bytes of data, numRequests if there is none.
+ * Its value isn't known, so the trace can only be simulated without data. */
+static inline size_t requests_first_wide_store(const struct Request *requests, size_t numRequests) {
+    for (size_t i = 0; i < numRequests; i++) {
+        if (requests[i].we && request_size(&requests[i]) > 4) {
+            return i;
+        }
+    }
+    return numRequests;
+}
+
+// Byte at addr + i of an access of size bytes with the value data
+static inline uint8_t access_byte(uint32_t data, unsigned size, unsigned i) {
+    unsigned shift = access_byte_shift(size, i);
+    return shift < 32 ? (uint8_t)(data >> shift) : 0;
+}
+
 #endif
@@ -6,6 +6,71 @@ struct Result {
     size_t misses;
     size_t hits;
     size_t primitiveGateCount;
+
+    // Only used with set sampling: simulated requests of the timed requests after the warm-up
+    // and 95% confidence half-widths of the estimates
+    size_t sampledRequests;
+    size_t timedRequests;
+    double cyclesMargin;
+    double missesMargin;
+    double hitsMargin;
+
+    // Only used with chunked simulation: requests of the serial validation run. The margins then hold
+    // the differences of the chunked run on these requests, the estimated error of the stitching
+    size_t validatedRequests;
+
+    /* Only used with the DRAM timing model: row buffer outcome of every fetched line and the cycles
+     * every bank was busy in channel, rank, bank order. bankBusyCycles is allocated with malloc
+     * and has to be freed by the caller. */
+    size_t rowHits;
+    size_t rowMisses;
+    size_t rowConflicts;
+    unsigned banks;
+    size_t* bankBusyCycles;
+
+    // Only used with the memory bus model: line fills and write-through stores, cycles the bus
+    // was transferring and cycles transfers waited for the bus
+    size_t busTransfers;
+    size_t busBusyCycles;
+    size_t busQueueingCycles;
+
+    // Balance of the requests over the sets (counted for the set of their first byte): sets of the cache,
+    // sets with at least one request, requests of the busiest set and the coefficient of variation of the
+    // requests per set. indexHashGateCount is the part of primitiveGateCount spent on the index function.
+    unsigned sets;
+    unsigned usedSets;
+    size_t maxSetAccesses;
+    double setAccessVariation;
+    size_t indexHashGateCount;
+
+    // Only used with sectored lines: fetches for a missing tag, fetches of a missing sector of a present
+    // line and the bytes of all fetches
+    size_t lineMisses;
+    size_t sectorMisses;
+    size_t fetchedBytes;
+
+    // Only used with a split L1: the part of hits and misses of the instruction cache
+    size_t instructionHits;
+    size_t instructionMisses;
+
+    // Only used with a lower level cache: lookups of the lines the L1 caches fetched
+    size_t lowerLevelHits;
+    size_t lowerLevelMisses;
+
+    // Only used with address translation: translations per outcome, cycles the CPU stalled for L2 TLB
+    // hits and walks, and page table reads of the walks that went through the cache (part of hits and misses)
+    size_t tlbHits;
+    size_t tlbL2Hits;
+    size_t tlbWalks;
+    size_t tlbStallCycles;
+    size_t walkRequests;
+
+    /* Only used if the trace has streams or the ways are partitioned: hits, misses and cycles of the
+     * streams 0 to streams - 1. The arrays are allocated with malloc and have to be freed by the caller. */
+    unsigned streams;
+    size_t* streamHits;
+    size_t* streamMisses;
+    size_t* streamCycles;
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,14 @@
+#ifndef SET_STATISTICS_HPP
+#define SET_STATISTICS_HPP
+
+#include <cstddef>
+
+// Counters of a single cache set. A request is counted for the set of its first byte.
+struct SetStatistics {
+    size_t accesses = 0;
+    size_t hits = 0;
+    size_t misses = 0;
+    size_t cycles = 0;
+};
+
+#endif
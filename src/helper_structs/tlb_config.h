@@ -0,0 +1,27 @@
+#ifndef TLB_CONFIG_H
+#define TLB_CONFIG_H
+
+// Pages of the address translation
+#define TLB_PAGE_4K 4096u
+#define TLB_PAGE_2M 2097152u
+
+// Translation stage ahead of the cache: two TLB levels and the page table walker
+struct TlbConfig {
+    // entries and ways of the L1 TLB, ways divides entries
+    unsigned l1Entries;
+    unsigned l1Ways;
+    // entries and ways of the L2 TLB (0 entries = no L2 TLB) and the cycles of an L2 TLB hit
+    unsigned l2Entries;
+    unsigned l2Ways;
+    unsigned l2Latency;
+
+    // TLB_PAGE_4K or TLB_PAGE_2M
+    unsigned pageSize;
+
+    // cycles of a page table walk on top of its page table reads
+    unsigned walkLatency;
+    // the page table reads of a walk are requests through the cache (0 = only walkLatency)
+    int walkThroughCache;
+};
+
+#endif
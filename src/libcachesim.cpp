@@ -0,0 +1,92 @@
+#include <new>
+
+#include "libcachesim.h"
+
+// engines without SystemC
+#include "engine/cpu_timing.hpp"
+#include "engine/functional_cache.hpp"
+
+// utils
+#include "utils/gate_count.hpp"
+
+// Opaque handle of the C interface
+struct CacheSimulator {
+    // only the cache of the configured address width has all sets, the other one a single set
+    unsigned addressWidth;
+    bool wideAddresses;
+    FunctionalCache cache;
+    WideFunctionalCache wideCache;
+    CpuTiming timing;
+    size_t primitiveGateCount;
+
+    CacheSimulator(const CacheSimulatorConfig& config) :
+    addressWidth(addressBits(config)), wideAddresses(config.addressBits > 32),
+    cache(config.directMapped, log2(config.cacheLineSize), wideAddresses ? 1 : sets(config)),
+    wideCache(config.directMapped, log2(config.cacheLineSize), wideAddresses ? sets(config) : 1),
+    timing(config.cycles, config.cacheLatency, config.memoryLatency),
+    primitiveGateCount(calculatePrimitiveGateCount(config.directMapped, config.cacheLines, config.cacheLineSize, addressBits(config))
+                       + calculateIndexHashGateCount(INDEX_BITSLICE, config.directMapped, config.cacheLines, config.cacheLineSize,
+                                                     addressBits(config))) {}
+
+    static unsigned sets(const CacheSimulatorConfig& config) {
+        return config.directMapped ? config.cacheLines : config.cacheLines / 4;
+    }
+
+    static unsigned addressBits(const CacheSimulatorConfig& config) {
+        return config.addressBits > 32 ? config.addressBits : 32;
+    }
+
+    unsigned accessRequest(const Request& request) {
+        return wideAddresses ? wideCache.accessRequest(request) : cache.accessRequest(request);
+    }
+};
+
+static bool isPowerOfTwo(unsigned n) {
+    return n != 0 && (n & (n - 1)) == 0;
+}
+
+extern "C" struct CacheSimulator* cache_simulator_create(const struct CacheSimulatorConfig* config) {
+    // Same restrictions as the command line
+    if(config == NULL || config->cycles < 0 || config->cacheLines == 0 || !isPowerOfTwo(config->cacheLineSize)
+       || (!config->directMapped && (config->cacheLines < 4 || config->cacheLines % 4 != 0))
+       || (config->addressBits != 0 && config->addressBits != 32 && config->addressBits != 48 && config->addressBits != 64)) {
+        return NULL;
+    }
+    // No exception may leave the C interface
+    try {
+        return new CacheSimulator(*config);
+    } catch(const std::bad_alloc&) {
+        return NULL;
+    }
+}
+
+extern "C" int cache_simulator_feed(struct CacheSimulator* simulator, const struct Request* requests, size_t numRequests) {
+    // The 32-bit tags would drop the upper address bits, like a trace wider than --address-bits
+    if(requests_address_bits(requests, numRequests) > simulator->addressWidth) {
+        return 1;
+    }
+    for(size_t i = 0; i < numRequests && simulator->timing.finished; ++i) {
+        simulator->timing.addRequests(&requests[i], 1, simulator->accessRequest(requests[i]));
+    }
+    return 0;
+}
+
+extern "C" int cache_simulator_warm_up(struct CacheSimulator* simulator, const struct Request* requests, size_t numRequests) {
+    if(requests_address_bits(requests, numRequests) > simulator->addressWidth) {
+        return 1;
+    }
+    for(size_t i = 0; i < numRequests; ++i) {
+        simulator->accessRequest(requests[i]);
+    }
+    return 0;
+}
+
+extern "C" struct Result cache_simulator_result(const struct CacheSimulator* simulator) {
+    Result result = simulator->timing.result();
+    result.primitiveGateCount = simulator->primitiveGateCount;
+    return result;
+}
+
+extern "C" void cache_simulator_destroy(struct CacheSimulator* simulator) {
+    delete simulator;
+}
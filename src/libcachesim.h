@@ -0,0 +1,54 @@
+#ifndef LIBCACHESIM_H
+#define LIBCACHESIM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "helper_structs/request.h"
+#include "helper_structs/result.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Embeddable cache simulator without SystemC. Every handle owns its own cache state and
+ * timing, so any number of them can run at the same time on different threads. A single
+ * handle must not be used by several threads at once.
+ * Hits, misses and cycles match run_simulation(), but read data isn't written back.
+ * Requests with size 0 access 4 bytes like before access sizes were supported, gap 0 has no compute cycles. */
+struct CacheSimulator;
+
+struct CacheSimulatorConfig {
+    // cycle limit like --cycles, requests after it are not counted
+    int cycles;
+    int directMapped;
+    // any number of cache lines, a multiple of 4 for a four-way cache, and a power of 2 line size
+    unsigned cacheLines;
+    unsigned cacheLineSize;
+    unsigned cacheLatency;
+    unsigned memoryLatency;
+    // address width of the hardware like --address-bits: 0 (same as 32), 32, 48 or 64. It sizes the gate count,
+    // 32 keeps the faster 32-bit tags. Requests beyond the width are rejected
+    unsigned addressBits;
+};
+
+// Creates a simulator with a cold cache, NULL if the configuration is invalid or memory is missing
+struct CacheSimulator* cache_simulator_create(const struct CacheSimulatorConfig* config);
+
+/* Simulates the next numRequests requests of the trace after all earlier batches.
+ * Returns 1 without simulating any of them if a request accesses bytes beyond addressBits, 0 otherwise. */
+int cache_simulator_feed(struct CacheSimulator* simulator, const struct Request* requests, size_t numRequests);
+
+// Updates the cache for the requests without counting them or advancing time, returns 1 like cache_simulator_feed()
+int cache_simulator_warm_up(struct CacheSimulator* simulator, const struct Request* requests, size_t numRequests);
+
+// Hits, misses and cycles of all requests fed so far, cycles are SIZE_MAX once the cycle limit is exceeded
+struct Result cache_simulator_result(const struct CacheSimulator* simulator);
+
+void cache_simulator_destroy(struct CacheSimulator* simulator);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
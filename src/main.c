@@ -10,8 +10,14 @@
 //helper structs
 #include "helper_structs/request.h"
 #include "helper_structs/result.h"
+#include "helper_structs/options.h"
+#include "helper_structs/cache_config.h"
 
-extern struct Result run_simulation(
+#include "trace.h"
+#include "server.h"
+#include "result_cache.h"
+
+extern struct Result run_simulation_with_options(
         int cycles,
         int directMapped,
         unsigned cacheLines,
@@ -20,7 +26,32 @@ extern struct Result run_simulation(
         unsigned memoryLatency,
         size_t numRequests,
         struct Request* requests,
-        const char* tracefile);
+        const char* tracefile,
+        const struct SimulationOptions* options);
+
+extern int write_filtered_trace(
+        const char* filename,
+        int directMapped,
+        unsigned cacheLines,
+        unsigned cacheLineSize,
+        unsigned cacheLatency,
+        unsigned memoryLatency,
+        size_t numRequests,
+        const struct Request* requests,
+        size_t warmupCount,
+        size_t* filteredRequests,
+        size_t* filteredWarmupRequests);
+
+extern void run_multi_simulation(
+        int cycles,
+        unsigned cacheLatency,
+        unsigned memoryLatency,
+        size_t numRequests,
+        struct Request* requests,
+        size_t numConfigs,
+        const struct CacheConfig* configs,
+        struct Result* results,
+        const struct SimulationOptions* options);
 
 const char *usage_msg =
         "Usage: %s [OPTIONS] <inputFile>   Run cache simulation with given operations in inputFile\n"
@@ -28,17 +59,82 @@ const char *usage_msg =
 
 const char *help_msg =
         "Positional arguments:\n"
-        "  inputFile   The file to get operations. Must be a .csv file.\n"
+        "  inputFile   The file to get operations. Must be a .csv file with lines <r|w|i>,<address>,<data>[,<size>[,<gap>[,<stream>]]],\n"
+        "              i is an instruction fetch, data is empty for reads and fetches and size is 1, 2, 4, 8, 16, 32 or 64 bytes (Default: 4).\n"
+        "              Stores wider than 4 bytes need --no-data, their data is only checked to fit into the size.\n"
+        "              gap is the number of compute cycles before the request (Default: 0) and stream the ID of\n"
+        "              the tenant that issued it, below 256 (Default: 0). Size and gap may be left empty before a later column.\n"
+        "              Addresses may have up to 64 bits, as many as --address-bits allows.\n"
+        "              Everything after # is a comment.\n"
         "\n"
         "Optional arguments:                (Default: 32KB directmapped L1 cache)\n"
         "  -c, --cycles <number>            Number of cycles to simulate (Default: 1000000000)\n"
         "      --directmapped               Simulate a direct-mapped cache. Can't set with --fourway option simultaneously (Default: directmapped)\n"
         "      --fourway                    Simulate a four-way associative cache. Can't set with --directmapped option simultaneously (Default: directmapped)\n"
         "      --cacheline-size <number>    Size of a cache line in bytes (Default: 64)\n"
-        "      --cachelines <number>        Number of cache lines (Default: 512)\n"
+        "      --cachelines <number>        Number of cache lines, a multiple of 4 for --fourway. Set counts that aren't a\n"
+        "                                   power of 2 index by the line address modulo the sets (Default: 512)\n"
         "      --cache-latency <number>     Cache latency in cycles (Default: 1)\n"
+        "      --address-bits <number>      Address width of the cache hardware: 32, 48 or 64 bits. It sizes tags, comparators\n"
+        "                                   and TLB entries, wider traces are rejected (Default: 32)\n"
         "      --memory-latency <number>    Memory latency in cycles (Default: 200)\n"
         "      --tf=<filename>              Output trace file with all signals\n"
+        "      --sample-rate <number>       Simulate only every n-th set (chosen by index hash) and extrapolate\n"
+        "                                   hits, misses and cycles with 95% confidence intervals (Default: 1)\n"
+        "      --load-state <filename>      Start from the cache and memory state of a snapshot instead of a cold cache\n"
+        "      --save-state <filename>      Write the final cache and memory state to a snapshot\n"
+        "      --warmup <number>            Run the first n requests untimed to warm up the cache, excluded from results (Default: 0)\n"
+        "      --threads <number>           Simulate hits, misses and cycles on n threads, partitioned by cache set (Default: 1)\n"
+        "      --chunks <number>            Split the trace into n contiguous chunks simulated in parallel and stitch\n"
+        "                                   their results, the error is estimated on a serially simulated prefix (Default: 1)\n"
+        "      --chunk-warmup <number>      Requests before every chunk that warm up its cache (Default: 10000)\n"
+        "      --compare <configs>          Simulate several caches in one pass and print a table. Comma separated list of\n"
+        "                                   <directmapped|fourway>:<cachelines>:<cacheline-size>, e.g. directmapped:512:64,fourway:512:64\n"
+        "      --tlm                        Simulate with loosely-timed TLM-2.0 transactions instead of pin-level signals\n"
+        "      --quantum <number>           Cycles the CPU may run ahead of the simulation time with --tlm (Default: 1000)\n"
+        "      --dram <c>:<r>:<b>:<size>    Time line fetches with a DRAM model of c channels, r ranks, b banks and rows of\n"
+        "                                   size bytes instead of --memory-latency (Default with any --dram option: 1:1:8:8192)\n"
+        "      --dram-latency <h>:<m>:<c>   Cycles of a row buffer hit, miss and conflict (Default: 100:200:300)\n"
+        "      --dram-policy <policy>       Row buffer policy: open or closed (Default: open)\n"
+        "      --dram-mapping <mapping>     Address mapping: page (row:channel:rank:bank:column), line (row:column:channel:\n"
+        "                                   rank:bank:offset) or xor (page with bank bits XORed with row bits) (Default: page)\n"
+        "      --bus-width <number>         Bytes per cycle of the memory bus. Line fills and write-through stores queue\n"
+        "                                   for it (Default: 0 = unlimited bandwidth)\n"
+        "      --index <function>           Set index function: bitslice, xor (XOR-folding of the upper bits), prime\n"
+        "                                   (modulo the largest prime <= sets) or skewed (own hash per way, four-way only).\n"
+        "                                   Prints the balance of the requests over the sets (Default: bitslice)\n"
+        "      --sector-size <number>       Split every line into sectors of this many bytes with their own valid bit,\n"
+        "                                   a miss only fetches the missing sector (Default: 0 = whole lines)\n"
+        "      --icache <t>:<n>:<size>      Split the L1 with --tlm: instruction fetches (i in the trace) go to an own\n"
+        "                                   instruction cache like an entry of --compare, the options above define the data cache\n"
+        "      --lower-level <t>:<n>:<size> Unified cache between the L1 caches and main memory, e.g. fourway:8192:64\n"
+        "      --lower-level-latency <n>    Cycles of a lower level lookup for every L1 fetch (Default: 10)\n"
+        "      --tlb <entries>:<ways>       Treat addresses as virtual and translate them with an L1 TLB first, a miss walks\n"
+        "                                   the page table, with 4 levels for traces above 4 GB (Default with any TLB option: 64:4)\n"
+        "      --l2-tlb <entries>:<ways>    Second TLB level searched on an L1 TLB miss (Default: none)\n"
+        "      --l2-tlb-latency <number>    Cycles of an L2 TLB hit (Default: 7)\n"
+        "      --page-size <4k|2m>          Page size of the translation (Default: 4k)\n"
+        "      --walk-latency <number>      Cycles of a page table walk on top of its page table reads (Default: 30)\n"
+        "      --walk-through-cache         Page table walks read their entries through the cache as own requests\n"
+        "      --way-mask <stream>:<mask>   Let the stream of the trace fill only the ways in the 4-bit mask of --fourway\n"
+        "                                   caches on a miss, e.g. 0:0x3 --way-mask 1:0xc. Repeat for every stream, streams\n"
+        "                                   without a mask fill all ways. Prints hits, misses and cycles of every stream\n"
+        "      --filter-trace <file.csv>    Also write the line fetches and stores the cache sends to the next level as a\n"
+        "                                   trace, which can be the input of a lower level study. The gap column holds the\n"
+        "                                   cache cycles in between, a comment the original request and its cycle\n"
+        "      --interval <number>[c]       Write hits, misses, cycles, evictions and occupancy of the (data) cache every n\n"
+        "                                   requests, or every n cycles with a trailing c, to find the phases of a trace.\n"
+        "                                   Each interval is appended while the simulation runs\n"
+        "      --interval-file <file>       File of the intervals, a CSV file or a JSON array if the name ends in .json\n"
+        "                                   (Default: intervals.csv)\n"
+        "      --no-data                    Simulate timing only: the cache keeps tags, main memory isn't modelled and\n"
+        "                                   read data isn't written back (less memory and time on large traces). Needed for\n"
+        "                                   stores wider than 4 bytes\n"
+        "      --serve <socket>             Run as daemon that simulates JSON jobs from a Unix socket, no inputFile needed\n"
+        "      --workers <number>           Preforked worker processes of the daemon (Default: 4)\n"
+        "      --trace-cache <number>       Parsed traces the daemon keeps in memory (Default: 8)\n"
+        "      --result-cache <directory>   Return the stored result of an identical earlier run (same trace contents and\n"
+        "                                   parameters) instead of simulating, and store the results of new runs\n"
         "  -h, --help                       Print this help message and exit\n";
 
 void print_usage(const char* progname) {
@@ -85,107 +181,130 @@ int is_power_of_two(unsigned n) {
     return (ceil(log2(n)) == floor(log2(n)));
 }
 
-int convert_hex_to_uint32_t(char *c, uint32_t *u) {
-    char *endptr;
-    errno = 0; // To distinguish success/failure after call
 
-    // Convert string to unsigned long
-    unsigned long value = strtoul(c, &endptr, 16);
 
-    // Check for conversion errors
-    if (endptr == c) {
-        // No digits were found
-        fprintf(stderr, "Invalid number: No digits were found in %s.\n", c);
-        return 1;
-    } else if (*endptr != '\0' && !isspace(*endptr)) {
-        // Further characters after the number
-        fprintf(stderr, "Invalid number: Further characters were found after the number: %s\n", endptr);
-        return 1;
-    } else if ((errno == ERANGE && value == ULONG_MAX) || (value > UINT_MAX)) {
-        // The value is out of range for unsigned int
-        fprintf(stderr, "Invalid number: The number %s is out of range for unsigned int.\n", c);
-        return 1;
-    } else if (errno != 0 && value == 0) {
-        // Other errors
-        fprintf(stderr, "Invalid number: %s\n", c);
-        return 1;
+/* Parses count colon separated unsigned numbers like 1:1:8:8192 into values.
+ * The list is modified while parsing. */
+int parse_unsigned_list(char *list, unsigned *values, size_t count) {
+    char *field = list;
+    for (size_t i = 0; i < count; i++) {
+        char *next = strchr(field, ':');
+        if ((next == NULL) != (i == count - 1)) {
+            fprintf(stderr, "Expected %zu colon separated numbers: %s\n", count, list);
+            return 1;
+        }
+        if (next != NULL) {
+            *next++ = '\0';
+        }
+        if (convert_unsigned(field, &values[i]) != 0) {
+            return 1;
+        }
+        field = next;
     }
-
-    // Parsing was successful
-    *u = (uint32_t)value;
     return 0;
 }
 
-int convert_dec_to_uint32_t(char *c, uint32_t *u) {
-    char *endptr;
-    errno = 0; // To distinguish success/failure after call
-
-    // Convert string to unsigned long
-    unsigned long value = strtoul(c, &endptr, 10);
+/* Parses the comma separated list of --compare into configs. Each entry has the form
+ * <directmapped|fourway>:<cachelines>:<cacheline-size>. The list is modified while parsing. */
+int parse_cache_configs(char *list, struct CacheConfig **configs, size_t *count) {
+    // one configuration more than commas
+    size_t capacity = 1;
+    for (char *c = list; *c != '\0'; c++) {
+        if (*c == ',') {
+            capacity++;
+        }
+    }
 
-    // Check for conversion errors
-    if (endptr == c) {
-        // No digits were found
-        fprintf(stderr, "Invalid number: No digits were found in %s.\n", c);
-        return 1;
-    } else if (*endptr != '\0' && !isspace(*endptr)) {
-        // Further characters after the number
-        fprintf(stderr, "Invalid number: Further characters were found after the number: %c\n", *endptr);
-        return 1;
-    } else if ((errno == ERANGE && value == ULONG_MAX) || (value > UINT_MAX)) {
-        // The value is out of range for unsigned int
-        fprintf(stderr, "Invalid number: The number %s is out of range for unsigned int.\n", c);
-        return 1;
-    } else if (errno != 0 && value == 0) {
-        // Other errors
-        fprintf(stderr, "Invalid number: %s\n", c);
+    *configs = (struct CacheConfig*)malloc(sizeof(struct CacheConfig) * capacity);
+    if (*configs == NULL) {
+        fprintf(stderr, "No space in memory: %s\n", strerror(errno));
         return 1;
     }
+    *count = 0;
 
-    // Parsing was successful
-    *u = (uint32_t)value;
-    return 0;
-}
-
-int is_csv_file(const char *filename) {
-    //get the length of the file and it can be maximum NAME_MAX
-    size_t len = strlen(filename);
-    // Check if the last four characters are ".csv"
-    return (len > 4 && strcmp(filename + len - 4, ".csv") == 0);
-}
+    char *entry = list;
+    while (entry != NULL) {
+        char *next = strchr(entry, ',');
+        if (next != NULL) {
+            *next++ = '\0';
+        }
 
-size_t count_lines(const char *filename) {
-    // count the number of lines in the file called filename implementing statically for now
+        // splitting the entry into its three fields
+        char *lines = strchr(entry, ':');
+        char *size = lines != NULL ? strchr(lines + 1, ':') : NULL;
+        if (lines == NULL || size == NULL) {
+            fprintf(stderr, "Invalid cache configuration: %s\n", entry);
+            return 1;
+        }
+        *lines++ = '\0';
+        *size++ = '\0';
+
+        struct CacheConfig *config = &(*configs)[(*count)++];
+        if (strcmp(entry, "directmapped") == 0) {
+            config->directMapped = 1;
+        } else if (strcmp(entry, "fourway") == 0) {
+            config->directMapped = 0;
+        } else {
+            fprintf(stderr, "Invalid cache type %s: must be directmapped or fourway\n", entry);
+            return 1;
+        }
 
-    FILE *fp = fopen(filename,"r");
-    size_t ch;
-    size_t lines = 0;
+        if (convert_unsigned(lines, &config->cacheLines) != 0 || convert_unsigned(size, &config->cacheLineSize) != 0) {
+            return 1;
+        }
+        if (config->cacheLines == 0) {
+            fprintf(stderr, "Cache lines must be at least 1: %u\n", config->cacheLines);
+            return 1;
+        }
+        if (config->cacheLineSize == 0 || !is_power_of_two(config->cacheLineSize)) {
+            fprintf(stderr, "Cache line size must be a power of 2: %u\n", config->cacheLineSize);
+            return 1;
+        }
+        if (!config->directMapped && (config->cacheLines < 4 || config->cacheLines % 4 != 0)) {
+            fprintf(stderr, "Cache lines of four-way cache must be a multiple of 4: %u\n", config->cacheLines);
+            return 1;
+        }
 
-    if (!fp) {
-        fprintf(stderr, "Error opening file %s: %s\n", filename, strerror(errno));
-        exit(EXIT_FAILURE);
+        entry = next;
     }
+    return 0;
+}
 
-    lines++;
-    while ((ch = fgetc(fp)) != EOF) {
-        if (ch == '\n')
-            lines++;
+/* Parses the single cache of --icache or --lower-level into config with the entry format of --compare.
+ * The text is modified while parsing. */
+int parse_cache_config(char *text, struct CacheConfig *config) {
+    struct CacheConfig *configs;
+    size_t count;
+    if (strchr(text, ',') != NULL) {
+        fprintf(stderr, "Only one cache configuration is allowed: %s\n", text);
+        return 1;
     }
-
-    fclose(fp);
-    return lines;
+    if (parse_cache_configs(text, &configs, &count) != 0) {
+        free(configs);
+        return 1;
+    }
+    *config = configs[0];
+    free(configs);
+    return 0;
 }
 
-int is_empty_line(char* l) {
-    for (int i = 0; l[i] != '\0'; i++) {
-        if (!isspace(l[i])) {
-            return 0;
-        }
+const char *index_function_name(enum IndexFunction function) {
+    switch (function) {
+        case INDEX_XOR:
+            return "xor";
+        case INDEX_PRIME:
+            return "prime";
+        case INDEX_SKEWED:
+            return "skewed";
+        default:
+            return "bitslice";
     }
-    return 1;
 }
 
 
+
+
+
 int main(int argc, char *argv[]) {
     //name of the program
     const char* progname = argv[0];
@@ -210,6 +329,89 @@ int main(int argc, char *argv[]) {
 
     const char *tracefile = NULL;
 
+    // caches of --compare, simulated in one pass instead of the single cache above
+    struct CacheConfig *configs = NULL;
+    size_t configCount = 0;
+
+    // optional features, all switched off by default
+    struct SimulationOptions options = {
+        .sampleRate = 1,
+        .loadStateFile = NULL,
+        .saveStateFile = NULL,
+        .warmupRequests = 0,
+        .threads = 1,
+        .chunks = 1,
+        .chunkWarmup = 10000,
+        .tlm = 0,
+        .quantum = 1000,
+        .dram = NULL,
+        .busBytesPerCycle = 0,
+        .noData = 0,
+        .indexFunction = INDEX_BITSLICE,
+        .sectorSize = 0,
+        .instructionCache = NULL,
+        .lowerLevel = NULL,
+        .lowerLevelLatency = 10,
+        .tlb = NULL,
+        .wayMasks = NULL,
+        .interval = 0,
+        .intervalInCycles = 0,
+        .intervalFile = "intervals.csv",
+        .intervalJson = 0,
+        .addressBits = 32
+    };
+    // set balance is printed if an index function is chosen
+    int index_defined = 0;
+
+    // caches of a split L1 and the level below it, only used if --icache or --lower-level is given
+    struct CacheConfig instructionCache;
+    struct CacheConfig lowerLevel;
+
+    // address translation, only used if a TLB option is given
+    int tlb_defined = 0;
+    struct TlbConfig tlb = {
+        .l1Entries = 64,
+        .l1Ways = 4,
+        .l2Entries = 0,
+        .l2Ways = 1,
+        .l2Latency = 7,
+        .pageSize = TLB_PAGE_4K,
+        .walkLatency = 30,
+        .walkThroughCache = 0
+    };
+
+    // way partitioning, the ways every stream may fill (0 = all ways)
+    int ways_defined = 0;
+    unsigned wayMasks[MAX_STREAMS] = {0};
+
+    // main memory organisation, only used if a --dram option is given
+    int dram_defined = 0;
+    struct DramConfig dram = {
+        .channels = 1,
+        .ranks = 1,
+        .banks = 8,
+        .rowSize = 8192,
+        .rowHitLatency = 100,
+        .rowMissLatency = 200,
+        .rowConflictLatency = 300,
+        .closedPage = 0,
+        .mapping = DRAM_MAPPING_PAGE
+    };
+
+    // daemon mode, simulates jobs from a socket instead of the inputFile
+    const char *serveSocket = NULL;
+    unsigned workers = 4;
+    unsigned cachedTraces = 8;
+
+    // miss and store stream of the cache, NULL = not written
+    const char *filterTrace = NULL;
+
+    // interval statistics file given without --interval
+    int interval_file_defined = 0;
+
+    // directory of stored results, NULL = always simulate
+    const char *resultCache = NULL;
+
     //required for getopt_long()
     static struct option long_options[] = {
         {"cycles", required_argument, NULL, 'c'},
@@ -223,6 +425,42 @@ int main(int argc, char *argv[]) {
         {"help", no_argument, NULL, 'h'},
         {"L2", no_argument, NULL, '2'},
         {"L3", no_argument, NULL, '3'},
+        {"sample-rate", required_argument, NULL, 'S'},
+        {"load-state", required_argument, NULL, 'R'},
+        {"save-state", required_argument, NULL, 'W'},
+        {"warmup", required_argument, NULL, 'U'},
+        {"threads", required_argument, NULL, 'P'},
+        {"chunks", required_argument, NULL, 'G'},
+        {"chunk-warmup", required_argument, NULL, 'I'},
+        {"compare", required_argument, NULL, 'C'},
+        {"tlm", no_argument, NULL, 'T'},
+        {"quantum", required_argument, NULL, 'Q'},
+        {"dram", required_argument, NULL, 'D'},
+        {"dram-latency", required_argument, NULL, 'A'},
+        {"dram-policy", required_argument, NULL, 'O'},
+        {"dram-mapping", required_argument, NULL, 'M'},
+        {"bus-width", required_argument, NULL, 'B'},
+        {"index", required_argument, NULL, 'X'},
+        {"sector-size", required_argument, NULL, 'V'},
+        {"icache", required_argument, NULL, 'J'},
+        {"lower-level", required_argument, NULL, 'Y'},
+        {"lower-level-latency", required_argument, NULL, 'y'},
+        {"tlb", required_argument, NULL, 'a'},
+        {"l2-tlb", required_argument, NULL, 'b'},
+        {"l2-tlb-latency", required_argument, NULL, 'e'},
+        {"page-size", required_argument, NULL, 'g'},
+        {"walk-latency", required_argument, NULL, 'j'},
+        {"walk-through-cache", no_argument, NULL, 'k'},
+        {"way-mask", required_argument, NULL, 'm'},
+        {"filter-trace", required_argument, NULL, 'o'},
+        {"interval", required_argument, NULL, 'i'},
+        {"interval-file", required_argument, NULL, 'p'},
+        {"address-bits", required_argument, NULL, 'x'},
+        {"no-data", no_argument, NULL, 'N'},
+        {"serve", required_argument, NULL, 'E'},
+        {"workers", required_argument, NULL, 'K'},
+        {"trace-cache", required_argument, NULL, 'Z'},
+        {"result-cache", required_argument, NULL, 'H'},
         {NULL, 0, NULL, 0}
         //final element has to be all zeros
     };
@@ -314,12 +552,329 @@ int main(int argc, char *argv[]) {
                 cachelines = 1 << 15;
                 cache_latency = 20;
                 break;
+                // set sampling
+            case 'S':
+                if (convert_unsigned(optarg, &options.sampleRate) != 0) {
+                    exit(EXIT_FAILURE);
+                }
+                if (options.sampleRate == 0) {
+                    fprintf(stderr, "Sample rate can't be 0\n");
+                    exit(EXIT_FAILURE);
+                }
+                break;
+                // snapshots
+            case 'R':
+                options.loadStateFile = optarg;
+                break;
+            case 'W':
+                options.saveStateFile = optarg;
+                break;
+                // functional warm-up
+            case 'U':
+                if (convert_unsigned(optarg, &options.warmupRequests) != 0) {
+                    exit(EXIT_FAILURE);
+                }
+                break;
+                // parallel simulation
+            case 'P':
+                if (convert_unsigned(optarg, &options.threads) != 0) {
+                    exit(EXIT_FAILURE);
+                }
+                if (options.threads == 0) {
+                    fprintf(stderr, "Threads can't be 0\n");
+                    exit(EXIT_FAILURE);
+                }
+                break;
+                // time-parallel simulation
+            case 'G':
+                if (convert_unsigned(optarg, &options.chunks) != 0) {
+                    exit(EXIT_FAILURE);
+                }
+                if (options.chunks == 0) {
+                    fprintf(stderr, "Chunks can't be 0\n");
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case 'I':
+                if (convert_unsigned(optarg, &options.chunkWarmup) != 0) {
+                    exit(EXIT_FAILURE);
+                }
+                break;
+                // multi-configuration simulation
+            case 'C':
+                free(configs);
+                if (parse_cache_configs(optarg, &configs, &configCount) != 0) {
+                    free(configs);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+                // transaction level simulation
+            case 'T':
+                options.tlm = 1;
+                break;
+            case 'Q':
+                if (convert_unsigned(optarg, &options.quantum) != 0) {
+                    exit(EXIT_FAILURE);
+                }
+                if (options.quantum == 0) {
+                    fprintf(stderr, "Quantum can't be 0\n");
+                    exit(EXIT_FAILURE);
+                }
+                break;
+                // DRAM timing model
+            case 'D': {
+                unsigned geometry[4];
+                if (parse_unsigned_list(optarg, geometry, 4) != 0) {
+                    exit(EXIT_FAILURE);
+                }
+                for (int i = 0; i < 4; i++) {
+                    if (geometry[i] == 0 || !is_power_of_two(geometry[i])) {
+                        fprintf(stderr, "Channels, ranks, banks and row size of --dram must be powers of 2\n");
+                        exit(EXIT_FAILURE);
+                    }
+                }
+                dram.channels = geometry[0];
+                dram.ranks = geometry[1];
+                dram.banks = geometry[2];
+                dram.rowSize = geometry[3];
+                dram_defined = 1;
+                break;
+            }
+            case 'A': {
+                unsigned latencies[3];
+                if (parse_unsigned_list(optarg, latencies, 3) != 0) {
+                    exit(EXIT_FAILURE);
+                }
+                dram.rowHitLatency = latencies[0];
+                dram.rowMissLatency = latencies[1];
+                dram.rowConflictLatency = latencies[2];
+                dram_defined = 1;
+                break;
+            }
+            case 'O':
+                if (strcmp(optarg, "open") == 0) {
+                    dram.closedPage = 0;
+                } else if (strcmp(optarg, "closed") == 0) {
+                    dram.closedPage = 1;
+                } else {
+                    fprintf(stderr, "Invalid row buffer policy %s: must be open or closed\n", optarg);
+                    exit(EXIT_FAILURE);
+                }
+                dram_defined = 1;
+                break;
+            case 'M':
+                if (strcmp(optarg, "page") == 0) {
+                    dram.mapping = DRAM_MAPPING_PAGE;
+                } else if (strcmp(optarg, "line") == 0) {
+                    dram.mapping = DRAM_MAPPING_LINE;
+                } else if (strcmp(optarg, "xor") == 0) {
+                    dram.mapping = DRAM_MAPPING_XOR;
+                } else {
+                    fprintf(stderr, "Invalid address mapping %s: must be page, line or xor\n", optarg);
+                    exit(EXIT_FAILURE);
+                }
+                dram_defined = 1;
+                break;
+                // memory bus model
+            case 'B':
+                if (convert_unsigned(optarg, &options.busBytesPerCycle) != 0) {
+                    exit(EXIT_FAILURE);
+                }
+                break;
+                // index function
+            case 'X':
+                if (strcmp(optarg, "bitslice") == 0) {
+                    options.indexFunction = INDEX_BITSLICE;
+                } else if (strcmp(optarg, "xor") == 0) {
+                    options.indexFunction = INDEX_XOR;
+                } else if (strcmp(optarg, "prime") == 0) {
+                    options.indexFunction = INDEX_PRIME;
+                } else if (strcmp(optarg, "skewed") == 0) {
+                    options.indexFunction = INDEX_SKEWED;
+                } else {
+                    fprintf(stderr, "Invalid index function %s: must be bitslice, xor, prime or skewed\n", optarg);
+                    exit(EXIT_FAILURE);
+                }
+                index_defined = 1;
+                break;
+                // sectored lines
+            case 'V':
+                if (convert_unsigned(optarg, &options.sectorSize) != 0) {
+                    exit(EXIT_FAILURE);
+                }
+                if (options.sectorSize == 0 || !is_power_of_two(options.sectorSize)) {
+                    fprintf(stderr, "Sector size must be a power of 2: %u\n", options.sectorSize);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+                // split L1 and lower level cache
+            case 'J':
+                if (parse_cache_config(optarg, &instructionCache) != 0) {
+                    exit(EXIT_FAILURE);
+                }
+                options.instructionCache = &instructionCache;
+                break;
+            case 'Y':
+                if (parse_cache_config(optarg, &lowerLevel) != 0) {
+                    exit(EXIT_FAILURE);
+                }
+                options.lowerLevel = &lowerLevel;
+                break;
+            case 'y':
+                if (convert_unsigned(optarg, &options.lowerLevelLatency) != 0) {
+                    exit(EXIT_FAILURE);
+                }
+                break;
+                // address translation
+            case 'a':
+            case 'b': {
+                unsigned level[2];
+                if (parse_unsigned_list(optarg, level, 2) != 0) {
+                    exit(EXIT_FAILURE);
+                }
+                if (level[0] == 0 || level[1] == 0 || level[0] % level[1] != 0) {
+                    fprintf(stderr, "TLB entries must be a positive multiple of the ways: %u:%u\n", level[0], level[1]);
+                    exit(EXIT_FAILURE);
+                }
+                if (opt == 'a') {
+                    tlb.l1Entries = level[0];
+                    tlb.l1Ways = level[1];
+                } else {
+                    tlb.l2Entries = level[0];
+                    tlb.l2Ways = level[1];
+                }
+                tlb_defined = 1;
+                break;
+            }
+            case 'e':
+                if (convert_unsigned(optarg, &tlb.l2Latency) != 0) {
+                    exit(EXIT_FAILURE);
+                }
+                tlb_defined = 1;
+                break;
+            case 'g':
+                if (strcmp(optarg, "4k") == 0 || strcmp(optarg, "4K") == 0) {
+                    tlb.pageSize = TLB_PAGE_4K;
+                } else if (strcmp(optarg, "2m") == 0 || strcmp(optarg, "2M") == 0) {
+                    tlb.pageSize = TLB_PAGE_2M;
+                } else {
+                    fprintf(stderr, "Invalid page size %s: must be 4k or 2m\n", optarg);
+                    exit(EXIT_FAILURE);
+                }
+                tlb_defined = 1;
+                break;
+            case 'j':
+                if (convert_unsigned(optarg, &tlb.walkLatency) != 0) {
+                    exit(EXIT_FAILURE);
+                }
+                tlb_defined = 1;
+                break;
+            case 'k':
+                tlb.walkThroughCache = 1;
+                tlb_defined = 1;
+                break;
+                // way partitioning
+            case 'm': {
+                char *mask = strchr(optarg, ':');
+                unsigned stream, ways;
+                if (mask == NULL) {
+                    fprintf(stderr, "Invalid way mask %s: must be <stream>:<mask>\n", optarg);
+                    exit(EXIT_FAILURE);
+                }
+                *mask++ = '\0';
+                if (convert_unsigned(optarg, &stream) != 0) {
+                    exit(EXIT_FAILURE);
+                }
+                errno = 0;
+                char *end;
+                ways = (unsigned)strtoul(mask, &end, 0);
+                if (errno != 0 || *mask == '\0' || *end != '\0' || ways == 0 || ways > 0xF) {
+                    fprintf(stderr, "Invalid way mask %s: must select 1 to 4 of the ways 0x1 to 0x8\n", mask);
+                    exit(EXIT_FAILURE);
+                }
+                if (stream >= MAX_STREAMS) {
+                    fprintf(stderr, "Invalid stream %u: must be below %u\n", stream, MAX_STREAMS);
+                    exit(EXIT_FAILURE);
+                }
+                wayMasks[stream] = ways;
+                ways_defined = 1;
+                break;
+            }
+                // filtered trace for the next level
+            case 'o':
+                filterTrace = optarg;
+                break;
+                // interval statistics, a trailing c counts the interval in cycles
+            case 'i': {
+                size_t len = strlen(optarg);
+                if (len > 1 && optarg[len - 1] == 'c') {
+                    optarg[len - 1] = '\0';
+                    options.intervalInCycles = 1;
+                }
+                if (convert_unsigned(optarg, &options.interval) != 0) {
+                    exit(EXIT_FAILURE);
+                }
+                if (options.interval == 0) {
+                    fprintf(stderr, "Interval can't be 0\n");
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            }
+            case 'p':
+                options.intervalFile = optarg;
+                interval_file_defined = 1;
+                break;
+                // address width of the hardware
+            case 'x':
+                if (convert_unsigned(optarg, &options.addressBits) != 0) {
+                    exit(EXIT_FAILURE);
+                }
+                if (options.addressBits != 32 && options.addressBits != 48 && options.addressBits != 64) {
+                    fprintf(stderr, "Invalid address width %u: must be 32, 48 or 64 bits\n", options.addressBits);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+                // timing only simulation
+            case 'N':
+                options.noData = 1;
+                break;
+                // daemon mode
+            case 'E':
+                serveSocket = optarg;
+                break;
+            case 'K':
+                if (convert_unsigned(optarg, &workers) != 0) {
+                    exit(EXIT_FAILURE);
+                }
+                if (workers == 0) {
+                    fprintf(stderr, "Workers can't be 0\n");
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case 'Z':
+                if (convert_unsigned(optarg, &cachedTraces) != 0) {
+                    exit(EXIT_FAILURE);
+                }
+                if (cachedTraces == 0) {
+                    fprintf(stderr, "Trace cache can't be 0\n");
+                    exit(EXIT_FAILURE);
+                }
+                break;
+                // result cache
+            case 'H':
+                resultCache = optarg;
+                break;
         default:
             print_usage(progname);
             exit(EXIT_FAILURE);
         }
     }
 
+    // Every job brings its own trace and cache parameters
+    if (serveSocket != NULL) {
+        return run_server(serveSocket, workers, cachedTraces) == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
     // No inputfile
     if (optind == argc) {
         fprintf(stderr, "Error: Missing positional argument -- <inputFile> is required\n");
@@ -327,19 +882,192 @@ int main(int argc, char *argv[]) {
         exit(EXIT_FAILURE);
     }
 
-    if(direct_mapped) {
-        if(!is_power_of_two(cachelines)) {
-            fprintf(stderr, "Attention: Cache lines of directmapped cache must be power of 2.\n"
-                            "           The simulation will be proceeded with %u cache lines\n", (cachelines = (unsigned)pow(2,ceil(log2(cachelines)))));
+    // Any number of sets works, a four-way cache only needs whole sets
+    if (!direct_mapped && cachelines % 4 != 0) {
+        fprintf(stderr, "Attention: Cache lines of four-way cache must be a multiple of 4.\n"
+                        "           The simulation will be proceeded with %u cache lines\n", (cachelines = (cachelines + 3) / 4 * 4));
+    }
+
+    // The parallel simulation only models tags and timing, without signals or cache contents
+    if (options.threads > 1 && (tracefile || options.sampleRate > 1 || options.loadStateFile || options.saveStateFile)) {
+        fprintf(stderr, "Error: --threads can't be combined with --tf, --sample-rate, --load-state or --save-state\n");
+        print_usage(progname);
+        exit(EXIT_FAILURE);
+    }
+
+    // The single pass simulation only models tags and timing like the parallel one
+    if (configCount > 0 && (tracefile || options.sampleRate > 1 || options.loadStateFile || options.saveStateFile
+                            || options.threads > 1)) {
+        fprintf(stderr, "Error: --compare can't be combined with --tf, --sample-rate, --load-state, --save-state or --threads\n");
+        print_usage(progname);
+        exit(EXIT_FAILURE);
+    }
+
+    // The TLM modules exchange transactions, so there are no signals to trace
+    if (options.tlm && (tracefile || options.threads > 1 || configCount > 0)) {
+        fprintf(stderr, "Error: --tlm can't be combined with --tf, --threads or --compare\n");
+        print_usage(progname);
+        exit(EXIT_FAILURE);
+    }
+
+    // The row buffers see every fetched line in order, which the engines without SystemC and sampling don't keep
+    if (dram_defined) {
+        if (options.threads > 1 || configCount > 0 || options.sampleRate > 1) {
+            fprintf(stderr, "Error: --dram options can't be combined with --threads, --compare or --sample-rate\n");
+            print_usage(progname);
+            exit(EXIT_FAILURE);
         }
-    } else {
-        if (!is_power_of_two(cachelines)){
-            fprintf(stderr, "Attention: Cache lines of four-way cache must be at least 4 and power of 2.\n"
-                            "           The simulation will be proceeded with %u cache lines\n", (cachelines = (unsigned)pow(2,ceil(log2(cachelines)))));
-        } else if (cachelines < 4) {
-            fprintf(stderr, "Attention: Cache lines of four-way cache must be at least 4 and power of 2.\n"
-                            "           The simulation will be proceeded with %u cache lines\n", (cachelines = 4));
+        if (dram.rowSize < cacheline_size) {
+            fprintf(stderr, "Error: DRAM row size %u must be at least the cache line size %u\n", dram.rowSize, cacheline_size);
+            exit(EXIT_FAILURE);
         }
+        options.dram = &dram;
+    }
+
+    // Queueing on the bus depends on the time of every transfer like the row buffers
+    if (options.busBytesPerCycle > 0 && (options.threads > 1 || configCount > 0 || options.sampleRate > 1)) {
+        fprintf(stderr, "Error: --bus-width can't be combined with --threads, --compare or --sample-rate\n");
+        print_usage(progname);
+        exit(EXIT_FAILURE);
+    }
+
+    // Chunks are simulated like --threads without SystemC, only their hits, misses and cycles are stitched
+    if (options.chunks > 1 && (tracefile || options.sampleRate > 1 || options.loadStateFile || options.saveStateFile
+                               || options.threads > 1 || configCount > 0 || options.tlm || dram_defined
+                               || options.busBytesPerCycle > 0)) {
+        fprintf(stderr, "Error: --chunks can't be combined with --tf, --sample-rate, --load-state, --save-state, --threads,\n"
+                        "       --compare, --tlm, --dram options or --bus-width\n");
+        print_usage(progname);
+        exit(EXIT_FAILURE);
+    }
+
+    // Only the SystemC caches hash their index, sampling and snapshots rely on the bit slice
+    if (options.indexFunction != INDEX_BITSLICE) {
+        if (options.threads > 1 || configCount > 0 || options.chunks > 1 || options.sampleRate > 1
+            || options.loadStateFile || options.saveStateFile) {
+            fprintf(stderr, "Error: --index can't be combined with --threads, --compare, --chunks, --sample-rate,\n"
+                            "       --load-state or --save-state\n");
+            print_usage(progname);
+            exit(EXIT_FAILURE);
+        }
+        if (options.indexFunction == INDEX_SKEWED && direct_mapped) {
+            fprintf(stderr, "Error: the skewed index function needs the ways of --fourway\n");
+            exit(EXIT_FAILURE);
+        }
+        // Folding and rotating work on whole index bits
+        unsigned sets = direct_mapped ? cachelines : cachelines / 4;
+        if ((options.indexFunction == INDEX_XOR || options.indexFunction == INDEX_SKEWED) && !is_power_of_two(sets)) {
+            fprintf(stderr, "Error: the xor and skewed index functions need a power of 2 sets, not %u\n", sets);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    // The sector valid bits only exist in the SystemC caches and aren't part of a snapshot
+    if (options.sectorSize > 0) {
+        if (options.threads > 1 || configCount > 0 || options.chunks > 1 || options.sampleRate > 1
+            || options.loadStateFile || options.saveStateFile) {
+            fprintf(stderr, "Error: --sector-size can't be combined with --threads, --compare, --chunks, --sample-rate,\n"
+                            "       --load-state or --save-state\n");
+            print_usage(progname);
+            exit(EXIT_FAILURE);
+        }
+        if (options.sectorSize > cacheline_size || cacheline_size / options.sectorSize > 64) {
+            fprintf(stderr, "Error: sector size %u must be at most the cache line size %u and at least 1/64 of it\n",
+                    options.sectorSize, cacheline_size);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    // The single pass simulation runs on the trace as it is, without a translation stage
+    if (tlb_defined) {
+        if (configCount > 0) {
+            fprintf(stderr, "Error: TLB options can't be combined with --compare\n");
+            print_usage(progname);
+            exit(EXIT_FAILURE);
+        }
+        options.tlb = &tlb;
+    }
+
+    // Only the SystemC four-way caches have ways to partition, snapshots keep the FIFO order of a whole set
+    if (ways_defined) {
+        if (direct_mapped) {
+            fprintf(stderr, "Error: --way-mask needs the ways of --fourway\n");
+            exit(EXIT_FAILURE);
+        }
+        if (options.threads > 1 || configCount > 0 || options.chunks > 1 || options.sampleRate > 1
+            || options.loadStateFile || options.saveStateFile) {
+            fprintf(stderr, "Error: --way-mask can't be combined with --threads, --compare, --chunks, --sample-rate,\n"
+                            "       --load-state or --save-state\n");
+            print_usage(progname);
+            exit(EXIT_FAILURE);
+        }
+        options.wayMasks = wayMasks;
+    }
+
+    // The pin-level CPU has one signal interface, only the TLM CPU has a second socket for the instruction cache
+    if (options.instructionCache && !options.tlm) {
+        fprintf(stderr, "Error: --icache needs --tlm\n");
+        print_usage(progname);
+        exit(EXIT_FAILURE);
+    }
+
+    // The engines without SystemC and sampling only model one cache, snapshots only hold the L1 data cache
+    if ((options.instructionCache || options.lowerLevel)
+        && (options.threads > 1 || configCount > 0 || options.chunks > 1 || options.sampleRate > 1
+            || options.loadStateFile || options.saveStateFile)) {
+        fprintf(stderr, "Error: --icache and --lower-level can't be combined with --threads, --compare, --chunks,\n"
+                        "       --sample-rate, --load-state or --save-state\n");
+        print_usage(progname);
+        exit(EXIT_FAILURE);
+    }
+
+    // A snapshot holds the cache and memory contents that aren't modelled without data
+    if (options.noData && (options.loadStateFile || options.saveStateFile)) {
+        fprintf(stderr, "Error: --no-data can't be combined with --load-state or --save-state\n");
+        print_usage(progname);
+        exit(EXIT_FAILURE);
+    }
+
+    // The filter replays the plain cache without SystemC, so only features that keep its miss stream are allowed
+    if (filterTrace) {
+        if (configCount > 0 || options.indexFunction != INDEX_BITSLICE || options.sectorSize > 0
+            || options.instructionCache || options.tlb || options.wayMasks) {
+            fprintf(stderr, "Error: --filter-trace can't be combined with --compare, --index, --sector-size, --icache,\n"
+                            "       TLB options or --way-mask\n");
+            print_usage(progname);
+            exit(EXIT_FAILURE);
+        }
+        if (!is_csv_file(filterTrace)) {
+            fprintf(stderr, "Not a valid csv fp -- %s\n", filterTrace);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    // The intervals are read from the counters of the SystemC caches while they simulate every set in one pass
+    if (options.interval > 0) {
+        if (options.threads > 1 || configCount > 0 || options.chunks > 1 || options.sampleRate > 1) {
+            fprintf(stderr, "Error: --interval can't be combined with --threads, --compare, --chunks or --sample-rate\n");
+            print_usage(progname);
+            exit(EXIT_FAILURE);
+        }
+        size_t len = strlen(options.intervalFile);
+        if (len > 5 && strcmp(options.intervalFile + len - 5, ".json") == 0) {
+            options.intervalJson = 1;
+        } else if (!is_csv_file(options.intervalFile)) {
+            fprintf(stderr, "Not a valid csv or json fp -- %s\n", options.intervalFile);
+            exit(EXIT_FAILURE);
+        }
+    } else if (interval_file_defined) {
+        fprintf(stderr, "Error: --interval-file needs --interval\n");
+        print_usage(progname);
+        exit(EXIT_FAILURE);
+    }
+
+    // Only plain results are stored, runs that read or write other files are always simulated
+    if (resultCache && (tracefile || options.loadStateFile || options.saveStateFile || configCount > 0 || options.interval > 0)) {
+        fprintf(stderr, "Error: --result-cache can't be combined with --tf, --load-state, --save-state, --compare or --interval\n");
+        print_usage(progname);
+        exit(EXIT_FAILURE);
     }
 
     const char *inputfile = argv[optind];
@@ -359,275 +1087,319 @@ int main(int argc, char *argv[]) {
     printf("Cache Lines: %d\n", cachelines);
     printf("Cache Latency: %d\n", cache_latency);
     printf("Memory Latency: %d\n", memory_latency);
+    printf("Address Bits: %u\n", options.addressBits);
     printf("Trace File: %s\n", tracefile ? tracefile : "None");
+    printf("Sample Rate: 1/%u\n", options.sampleRate);
+    printf("Load State: %s\n", options.loadStateFile ? options.loadStateFile : "None");
+    printf("Save State: %s\n", options.saveStateFile ? options.saveStateFile : "None");
+    printf("Warmup Requests: %u\n", options.warmupRequests);
+    printf("Threads: %u\n", options.threads);
+    printf("Chunks: %u (warm-up %u requests)\n", options.chunks, options.chunkWarmup);
+    printf("Compared Configurations: %zu\n", configCount);
+    printf("TLM: %d\n", options.tlm);
+    printf("Quantum: %u\n", options.quantum);
+    if (options.dram) {
+        printf("DRAM: %u channels, %u ranks, %u banks, %u byte rows\n", dram.channels, dram.ranks, dram.banks, dram.rowSize);
+        printf("DRAM Latency: hit %u, miss %u, conflict %u\n", dram.rowHitLatency, dram.rowMissLatency, dram.rowConflictLatency);
+        printf("DRAM Policy: %s\n", dram.closedPage ? "closed" : "open");
+        printf("DRAM Mapping: %s\n", dram.mapping == DRAM_MAPPING_PAGE ? "page" : dram.mapping == DRAM_MAPPING_LINE ? "line" : "xor");
+    } else {
+        printf("DRAM: None\n");
+    }
+    if (options.busBytesPerCycle > 0) {
+        printf("Bus Width: %u bytes/cycle\n", options.busBytesPerCycle);
+    } else {
+        printf("Bus Width: Unlimited\n");
+    }
+    printf("Index Function: %s\n", index_function_name(options.indexFunction));
+    printf("Sector Size: %u\n", options.sectorSize);
+    if (options.instructionCache) {
+        printf("Instruction Cache: %s, %u lines of %u bytes\n", instructionCache.directMapped ? "directmapped" : "fourway",
+               instructionCache.cacheLines, instructionCache.cacheLineSize);
+    } else {
+        printf("Instruction Cache: Unified\n");
+    }
+    if (options.lowerLevel) {
+        printf("Lower Level: %s, %u lines of %u bytes, latency %u\n", lowerLevel.directMapped ? "directmapped" : "fourway",
+               lowerLevel.cacheLines, lowerLevel.cacheLineSize, options.lowerLevelLatency);
+    } else {
+        printf("Lower Level: None\n");
+    }
+    if (options.tlb) {
+        printf("TLB: %u entries, %u ways\n", tlb.l1Entries, tlb.l1Ways);
+        if (tlb.l2Entries > 0) {
+            printf("L2 TLB: %u entries, %u ways, latency %u\n", tlb.l2Entries, tlb.l2Ways, tlb.l2Latency);
+        } else {
+            printf("L2 TLB: None\n");
+        }
+        printf("Page Size: %s\n", tlb.pageSize == TLB_PAGE_2M ? "2m" : "4k");
+        printf("Walk Latency: %u%s\n", tlb.walkLatency, tlb.walkThroughCache ? " + page table reads through the cache" : "");
+    } else {
+        printf("TLB: None\n");
+    }
+    if (options.wayMasks) {
+        printf("Way Masks:");
+        for (unsigned stream = 0; stream < MAX_STREAMS; stream++) {
+            if (wayMasks[stream] != 0) {
+                printf(" %u:0x%x", stream, wayMasks[stream]);
+            }
+        }
+        printf("\n");
+    } else {
+        printf("Way Masks: None\n");
+    }
+    printf("Filtered Trace: %s\n", filterTrace ? filterTrace : "None");
+    if (options.interval > 0) {
+        printf("Interval: %u %s to %s\n", options.interval, options.intervalInCycles ? "cycles" : "requests", options.intervalFile);
+    } else {
+        printf("Interval: None\n");
+    }
+    printf("No Data: %d\n", options.noData);
+    printf("Result Cache: %s\n", resultCache ? resultCache : "None");
     printf("Input File: %s\n\n", inputfile);
 
-    //All lines are counted including blank and invalid lines
-    size_t linesCount = count_lines(inputfile);
-    size_t emptyLinesCount = 0;
-
-    //Open fp for reading
-    FILE *fp = fopen(inputfile, "r");
-    if (!fp) {
-        fprintf(stderr, "Error opening fp %s: %s\n", inputfile, strerror(errno));
-        return 1;
+    /* Every parameter that changes the result is part of the key. The thread count, the quantum and
+     * --no-data are left out because they don't change the result, so those runs share their entries. */
+    uint64_t resultKey;
+    uint64_t parameters[] = {
+        (uint64_t)cycles, direct_mapped, cachelines, cacheline_size, cache_latency, memory_latency, options.addressBits,
+        options.sampleRate, options.warmupRequests, options.tlm, options.busBytesPerCycle,
+        options.chunks > 1 ? options.chunks : 1, options.chunks > 1 ? options.chunkWarmup : 0, options.indexFunction,
+        options.sectorSize,
+        options.instructionCache != NULL, options.instructionCache ? instructionCache.directMapped : 0,
+        options.instructionCache ? instructionCache.cacheLines : 0, options.instructionCache ? instructionCache.cacheLineSize : 0,
+        options.lowerLevel != NULL, options.lowerLevel ? lowerLevel.directMapped : 0,
+        options.lowerLevel ? lowerLevel.cacheLines : 0, options.lowerLevel ? lowerLevel.cacheLineSize : 0,
+        options.lowerLevel ? options.lowerLevelLatency : 0,
+        options.tlb != NULL, tlb.l1Entries, tlb.l1Ways, tlb.l2Entries, tlb.l2Ways, tlb.l2Latency, tlb.pageSize,
+        tlb.walkLatency, tlb.walkThroughCache,
+        options.dram != NULL, dram.channels, dram.ranks, dram.banks, dram.rowSize, dram.rowHitLatency,
+        dram.rowMissLatency, dram.rowConflictLatency, dram.closedPage, dram.mapping
+    };
+    struct Result result;
+
+    // The way masks follow with 16 streams of 4 bits per parameter
+    size_t parameterCount = sizeof(parameters) / sizeof(parameters[0]);
+    uint64_t keyParameters[sizeof(parameters) / sizeof(parameters[0]) + MAX_STREAMS / 16] = {0};
+    memcpy(keyParameters, parameters, sizeof(parameters));
+    for (unsigned stream = 0; stream < MAX_STREAMS; stream++) {
+        keyParameters[parameterCount + stream / 16] |= (uint64_t)wayMasks[stream] << (4 * (stream % 16));
     }
-    // Request array the number of requests is <= linesCount
-    struct Request* requests = (struct Request*)malloc(sizeof(struct Request) * linesCount);
-    if(requests == NULL) {
-        fprintf(stderr, "No space in memory: %s\n", strerror(errno));
-        fclose(fp);
+
+    if (resultCache && result_cache_key(inputfile, keyParameters, sizeof(keyParameters) / sizeof(keyParameters[0]), &resultKey) != 0) {
         exit(EXIT_FAILURE);
     }
 
-    // Buffer for reading line
-    char line[256];
-
-    // String of parsed value
-    char *column;
+    // A stored result is returned without parsing the trace, it is only parsed for the filtered trace then
+    int storedResult = resultCache && result_cache_load(resultCache, resultKey, &result) == 0;
 
-    //Request requestCount
-    uint32_t requestCount = 0;
-
-    // Reading lines one by one
-    while (fgets(line, sizeof(line), fp)) {
-
-        // check if the line empty
-        if(is_empty_line(line)) {
-            emptyLinesCount++;
-            continue;
-        }
-
-        // Temp request members
-        int we;
-        uint32_t address;
-        uint32_t data = 0;
-
-        // Boolean for deciding whether the column empty
-        int parsed;
-
-        // First column was empty
-        if(line[0] == ',') {
-            fprintf(stderr, "No operation is given at line %zu\n", requestCount + emptyLinesCount + 1);
-            fclose(fp);
-            free(requests);
+    struct Request* requests = NULL;
+    size_t requestCount = 0;
+    if (!storedResult || filterTrace) {
+        if (read_trace(inputfile, &requests, &requestCount) != 0) {
             exit(EXIT_FAILURE);
         }
 
-
-        // Reading first column
-        if ((column = strtok(line, ",")) == NULL) {
-            fprintf(stderr, "Invalid line at %zu found.\n", requestCount + emptyLinesCount + 1);
-            fclose(fp);
+        if(requestCount == 0) {
+            fprintf(stderr, "No operation is given. Nothing to run.\n");
             free(requests);
             exit(EXIT_FAILURE);
         }
 
-
-        /*
-         * Columns are parsed to strings and the legal values
-         * are either 'w' or 'r' and doesn't matter capital or
-         * not. Before and after letter only white space can be present
-         */
-
-        // Boolean to make sure that just 1 operation is parsed
-        int found = 0;
-
-        // After parsing, it should be 1
-        parsed = 0;
-
-        // Iterating first column
-        for (int i = 0; column[i] != '\0'; i++) {
-            //If white space then skip
-            if (isspace(column[i])) {
-                continue;
-            } else if ((column[i] == 'W' || column[i] == 'w') && !found) {
-                we = 1;
-                //Assign found and parsed variables to true and be sure that after the letter just space comes
-                found = 1;
-                parsed = 1;
-            } else if ((column[i] == 'R' || column[i] == 'r') && !found) {
-                we = 0;
-                //Assign found and parsed variables to true and be sure that after the letter just space comes
-                found = 1;
-                parsed = 1;
-            } else {
-                //Either no letter found or more than one
-                fprintf(stderr, "Invalid operation at line %zu found: ASCII: %.2x\n", requestCount + emptyLinesCount + 1, column[i]);
-                fclose(fp);
-                free(requests);
-                exit(EXIT_FAILURE);
-            }
-        }
-
-        // The column was empty
-        if (!parsed) {
-            fprintf(stderr, "No operation is found in line %zu.\n", requestCount + emptyLinesCount + 1);
-            fclose(fp);
+        if(options.warmupRequests >= requestCount) {
+            fprintf(stderr, "Warm-up of %u requests leaves none of the %zu requests to simulate.\n", options.warmupRequests, requestCount);
             free(requests);
             exit(EXIT_FAILURE);
         }
 
-        // Reading second column
-        if ((column = strtok(NULL,",")) == NULL) {
-            fprintf(stderr, "Invalid line at %zu found.\n", requestCount + emptyLinesCount + 1);
-            fclose(fp);
+        unsigned traceAddressBits = requests_address_bits(requests, requestCount);
+        if(traceAddressBits > options.addressBits) {
+            fprintf(stderr, "The trace has %u-bit addresses, more than the %u of --address-bits.\n", traceAddressBits, options.addressBits);
             free(requests);
             exit(EXIT_FAILURE);
         }
 
-        // strtok() skip if two separator next to each other like ",,". So test if there was a ',' before token
-        if (column[-1] == ',') {
-            fprintf(stderr, "No address is found in line %zu.\n", requestCount + emptyLinesCount + 1);
-            fclose(fp);
+        // Zeros in place of the unknown upper bytes would end up in the cache and the read data
+        size_t wideStore = requests_first_wide_store(requests, requestCount);
+        if(wideStore < requestCount && !options.noData) {
+            fprintf(stderr, "Request %zu stores %u bytes, but data is only kept for up to 4 bytes. Simulate it with --no-data.\n",
+                    wideStore + 1, request_size(&requests[wideStore]));
             free(requests);
             exit(EXIT_FAILURE);
         }
+    }
 
-
-        // After parsing, it should be 1
-        parsed = 0;
-        // Iterating second column
-        for (int i = 0; column[i] != '\0'; i++) {
-            if (isspace(column[i])) {
-                continue;
-            } else if (column[i] == '0' && (column[i + 1] == 'x' || column[i + 1] == 'X')) {
-                // If after '0' a 'X' comes try to convert hex
-                if (convert_hex_to_uint32_t(column, &address) != 0) {
-                    fclose(fp);
-                    free(requests);
-                    exit(EXIT_FAILURE);
-                }
-                // Update parsed variable
-                parsed = 1;
-                break;
-            } else {
-                // else try to convert to decimal
-                if (convert_dec_to_uint32_t(column, &address) != 0) {
-                    fclose(fp);
-                    free(requests);
-                    exit(EXIT_FAILURE);
-                }
-                // Update parsed variable
-                parsed = 1;
-                break;
-            }
-        }
-
-        // The column was empty
-        if (!parsed) {
-            fprintf(stderr, "No address is found in line %zu.\n", requestCount + emptyLinesCount + 1);
-            fclose(fp);
+    if (configCount > 0) {
+        struct Result* results = (struct Result*)malloc(sizeof(struct Result) * configCount);
+        if (results == NULL) {
+            fprintf(stderr, "No space in memory: %s\n", strerror(errno));
+            free(configs);
             free(requests);
             exit(EXIT_FAILURE);
         }
 
-        /*
-         * Reading third column
-         * For read operation it can be NULL or after ',' just empty chars
-         * but not for write
-         */
-        if((column = strtok(NULL,",")) == NULL && we == 1) {
-            fprintf(stderr, "At line %zu invalid write operation.\n", requestCount + emptyLinesCount + 1);
-            fclose(fp);
-            free(requests);
-            exit(EXIT_FAILURE);
-        }
+        run_multi_simulation(cycles, cache_latency, memory_latency, requestCount, requests,
+                             configCount, configs, results, &options);
 
-        /* strtok() skip if two separator next to each other like ",,". So test if there was a ',' before token.
-         * If there was a ',' before it means more than 2 commas are used, and it is illegal because it can only
-         * have 3 columns */
-        if (column != NULL && column[-1] == ',') {
-            fprintf(stderr, "Too many arguments for operation at line %zu.\n", requestCount + emptyLinesCount + 1);
-            fclose(fp);
-            free(requests);
-            exit(EXIT_FAILURE);
+        printf("OUTPUT:\n"
+               "%-14s %10s %10s %20s %12s %12s %14s\n",
+               "Cache", "Lines", "LineSize", "Cycles", "Hits", "Misses", "PrimitiveGate");
+        for (size_t i = 0; i < configCount; i++) {
+            printf("%-14s %10u %10u %20zu %12zu %12zu %14zu\n",
+                   configs[i].directMapped ? "directmapped" : "fourway", configs[i].cacheLines, configs[i].cacheLineSize,
+                   results[i].cycles, results[i].hits, results[i].misses, results[i].primitiveGateCount);
         }
 
-        parsed = 0;
-
-        /*
-         * If it's not NULL it can have a value or empty. For write it must have
-         * a value but for read it must be empty if it's not NULL.
-        */
-        if (column != NULL) {
-            for (int i = 0; column[i] != '\0'; i++) {
-                if (isspace(column[i])) {
-                    continue;
-                } else if (we == 0) {
-                    /* This branch shows that the found character is
-                     * different from empty chars
-                     * and its illegal in a read operation
-                     * */
-                    fprintf(stderr, "A data (ASCII: %.2x) has been found for read operation at line %zu. Read operation can't have a data\n",
-                            column[i], requestCount + emptyLinesCount + 1);
-                    fclose(fp);
-                    free(requests);
-                    exit(EXIT_FAILURE);
-                } else if (column[i] == '0' && (column[i + 1] == 'x' || column[i + 1] == 'X')) {
-                    if(convert_hex_to_uint32_t(column, &data) != 0) {
-                        fclose(fp);
-                        free(requests);
-                        exit(EXIT_FAILURE);
-                    }
-                    parsed = 1;
-                    break;
-                } else {
-                    if(convert_dec_to_uint32_t(column, &data) != 0) {
-                        fclose(fp);
-                        free(requests);
-                        exit(EXIT_FAILURE);
-                    }
-                    parsed = 1;
-                    break;
-                }
-            }
-        }
+        free(results);
+        free(configs);
+        free(requests);
+        return 0;
+    }
 
-        // The column was empty and not OK for write operation
-        if (!parsed && we == 1) {
-            fprintf(stderr, "At line %zu the write operation doesn't have a value.\n", requestCount + emptyLinesCount + 1);
-            fclose(fp);
+    // The filtered trace only depends on the requests and the cache, so it's written even for a stored result
+    if (filterTrace) {
+        size_t filteredRequests, filteredWarmupRequests;
+        if (write_filtered_trace(filterTrace, direct_mapped, cachelines, cacheline_size, cache_latency, memory_latency,
+                                 requestCount, requests, options.warmupRequests,
+                                 &filteredRequests, &filteredWarmupRequests) != 0) {
+            fprintf(stderr, "Error writing the filtered trace %s: %s\n", filterTrace, strerror(errno));
             free(requests);
             exit(EXIT_FAILURE);
         }
+        printf("Filtered Trace: %zu requests (%zu from warm-up) written to %s\n",
+               filteredRequests, filteredWarmupRequests, filterTrace);
+    }
 
-
-        /* If next strtok() doesn't return NULL it means more than
-         * 2 commas are used and that's illegal */
-        if(column != NULL && strtok(NULL,",") != NULL) {
-            fprintf(stderr, "At line %zu too many arguments for operation.\n", requestCount + emptyLinesCount + 1);
-            fclose(fp);
-            free(requests);
-            exit(EXIT_FAILURE);
+    if (storedResult) {
+        printf("Stored result %016llx\n", (unsigned long long)resultKey);
+    } else {
+        result = run_simulation_with_options(cycles, direct_mapped, cachelines, cacheline_size,
+                                             cache_latency, memory_latency, requestCount, requests,
+                                             tracefile, &options);
+        if (resultCache) {
+            result_cache_store(resultCache, resultKey, &result);
         }
+    }
+    if (options.sampleRate > 1) {
+        // Extrapolated values with their 95% confidence intervals
+        printf("OUTPUT (estimated from %zu of %zu requests):\n"
+               "Cycles: %zu (+/- %.0f)\n"
+               "Hits: %zu (+/- %.0f)\n"
+               "Misses: %zu (+/- %.0f)\n"
+               "PrimitiveGate: %zu\n",
+               result.sampledRequests, result.timedRequests, result.cycles, result.cyclesMargin,
+               result.hits, result.hitsMargin, result.misses, result.missesMargin, result.primitiveGateCount);
+    } else if (options.chunks > 1) {
+        // Stitched values with the differences to a serial run on the validation prefix
+        printf("OUTPUT (stitched from %u chunks, error estimated on %zu requests):\n"
+               "Cycles: %zu (+/- %.0f)\n"
+               "Hits: %zu (+/- %.0f)\n"
+               "Misses: %zu (+/- %.0f)\n"
+               "PrimitiveGate: %zu\n",
+               options.chunks, result.validatedRequests, result.cycles, result.cyclesMargin,
+               result.hits, result.hitsMargin, result.misses, result.missesMargin, result.primitiveGateCount);
+    } else {
+        printf("OUTPUT:\n"
+               "Cycles: %zu\n"
+               "Hits: %zu\n"
+               "Misses: %zu\n"
+               "PrimitiveGate: %zu\n",
+               result.cycles, result.hits, result.misses, result.primitiveGateCount);
+    }
+
+    if (index_defined) {
+        printf("Index Function: %s\n"
+               "Used Sets: %u of %u\n"
+               "Busiest Set Requests: %zu\n"
+               "Set Requests Variation: %.3f\n"
+               "Index Hash Gates: %zu\n",
+               index_function_name(options.indexFunction), result.usedSets, result.sets,
+               result.maxSetAccesses, result.setAccessVariation, result.indexHashGateCount);
+    }
 
+    if (options.sectorSize > 0) {
+        printf("Line Misses: %zu\n"
+               "Sector Misses: %zu\n"
+               "Fetched Bytes: %zu\n",
+               result.lineMisses, result.sectorMisses, result.fetchedBytes);
+    }
 
-        // Updating request members
-        requests[requestCount].addr = address;
-        requests[requestCount].we = we;
-        requests[requestCount].data = data;
+    if (options.instructionCache) {
+        printf("Instruction Cache Hits: %zu\n"
+               "Instruction Cache Misses: %zu\n"
+               "Data Cache Hits: %zu\n"
+               "Data Cache Misses: %zu\n",
+               result.instructionHits, result.instructionMisses,
+               result.hits - result.instructionHits, result.misses - result.instructionMisses);
+    }
 
-        // Next request, next line
-        requestCount++;
+    if (options.lowerLevel) {
+        size_t lookups = result.lowerLevelHits + result.lowerLevelMisses;
+        printf("Lower Level Hits: %zu\n"
+               "Lower Level Misses: %zu\n"
+               "Lower Level Hit Rate: %.2f%%\n",
+               result.lowerLevelHits, result.lowerLevelMisses,
+               lookups > 0 ? 100.0 * result.lowerLevelHits / lookups : 0.0);
     }
-    fclose(fp);
 
+    if (options.tlb) {
+        size_t translations = result.tlbHits + result.tlbL2Hits + result.tlbWalks;
+        printf("TLB Hits: %zu\n"
+               "L2 TLB Hits: %zu\n"
+               "Page Walks: %zu\n"
+               "TLB Miss Rate: %.2f%%\n"
+               "TLB Stall Cycles: %zu\n"
+               "Page Walk Requests: %zu\n",
+               result.tlbHits, result.tlbL2Hits, result.tlbWalks,
+               translations > 0 ? 100.0 * result.tlbWalks / translations : 0.0,
+               result.tlbStallCycles, result.walkRequests);
+    }
 
-    if(requestCount == 0) {
-        fprintf(stderr, "No operation is given. Nothing to run.\n");
-        free(requests);
-        exit(EXIT_FAILURE);
+    if (options.dram) {
+        size_t fetches = result.rowHits + result.rowMisses + result.rowConflicts;
+        printf("Row Buffer Hits: %zu\n"
+               "Row Buffer Misses: %zu\n"
+               "Row Buffer Conflicts: %zu\n"
+               "Row Buffer Hit Rate: %.2f%%\n",
+               result.rowHits, result.rowMisses, result.rowConflicts,
+               fetches > 0 ? 100.0 * result.rowHits / fetches : 0.0);
+
+        // Share of the simulated cycles every bank spent on fetching lines
+        for (unsigned bank = 0; bank < result.banks; bank++) {
+            unsigned channel = bank / (dram.ranks * dram.banks);
+            unsigned rank = bank / dram.banks % dram.ranks;
+            double utilization = result.cycles != SIZE_MAX && result.cycles > 0
+                                 ? 100.0 * result.bankBusyCycles[bank] / result.cycles : 0.0;
+            printf("Bank %u/%u/%u Utilization: %.2f%%\n", channel, rank, bank % dram.banks, utilization);
+        }
+        free(result.bankBusyCycles);
     }
 
-    struct Result result = run_simulation(cycles, direct_mapped, cachelines, cacheline_size,
-                                          cache_latency, memory_latency, requestCount, requests, tracefile);
-    printf("OUTPUT:\n"
-           "Cycles: %zu\n"
-           "Hits: %zu\n"
-           "Misses: %zu\n"
-           "PrimitiveGate: %zu\n",
-           result.cycles, result.hits, result.misses, result.primitiveGateCount);
+    // Streams without requests are left out
+    for (unsigned stream = 0; stream < result.streams; stream++) {
+        if (result.streamHits[stream] + result.streamMisses[stream] == 0) {
+            continue;
+        }
+        printf("Stream %u: Hits %zu, Misses %zu, Cache Cycles %zu", stream,
+               result.streamHits[stream], result.streamMisses[stream], result.streamCycles[stream]);
+        if (options.wayMasks) {
+            printf(", Ways 0x%x", wayMasks[stream] != 0 ? wayMasks[stream] : 0xF);
+        }
+        printf("\n");
+    }
+    free(result.streamHits);
+    free(result.streamMisses);
+    free(result.streamCycles);
+
+    if (options.busBytesPerCycle > 0) {
+        printf("Bus Transfers: %zu\n"
+               "Bus Utilization: %.2f%%\n"
+               "Bus Queueing Delay: %zu cycles (%.2f per transfer)\n",
+               result.busTransfers,
+               result.cycles != SIZE_MAX && result.cycles > 0 ? 100.0 * result.busBusyCycles / result.cycles : 0.0,
+               result.busQueueingCycles,
+               result.busTransfers > 0 ? (double)result.busQueueingCycles / result.busTransfers : 0.0);
+    }
 
         free(requests);
         return 0;
@@ -0,0 +1,254 @@
+#ifndef DIRECT_MAPPED_MODEL_HPP
+#define DIRECT_MAPPED_MODEL_HPP
+
+#include <cstdint>
+#include <istream>
+#include <map>
+#include <ostream>
+#include <vector>
+
+// helper structs
+#include "../helper_structs/request.h"
+#include "../helper_structs/cache_line.hpp"
+#include "../helper_structs/set_statistics.hpp"
+#include "../utils/snapshot.hpp"
+#include "../utils/index_hash.hpp"
+
+/* State of the direct-mapped cache and its main memory without any timing.
+ * Used by the pin-level DIRECT_MAPPED_CACHE and the TLM target, which add the latencies.
+ * Address is the width of addresses and tags, like for the engines without SystemC:
+ * DirectMappedModel keeps 32-bit tags, WideDirectMappedModel is for traces above 4 GB. */
+template<typename Address>
+struct BasicDirectMappedModel {
+
+    typedef Address Tag;
+
+    // cache related
+    unsigned
+    cacheLineSize = 0,
+
+    // address related
+    offsetBitsCount = 0,
+    offsetBitsMask = 0;
+
+    // selects the index and tag of an address, a bit slice unless another index function is chosen
+    IndexHash indexHash;
+
+    // memory related
+    //////////////////////////////////////////////////////////////////////////////////////////////////
+
+    std::map<uint32_t, CacheLine<Tag>> cache; // cache with cacheLines and cacheLineSize defined during runtime
+
+    std::map<Address, uint8_t> mainMemory; // main memory that doesn't need to be initialized fully but only the needed values
+
+    std::vector<SetStatistics> setStatistics; // hits, misses and cycles of every index, one entry per cache line
+
+    std::vector<SetStatistics> streamStatistics; // hits, misses and cycles of every stream, MAX_STREAMS entries
+
+    std::vector<uint64_t> fetchedLineAddresses; // lines fetched from main memory during the current request
+
+    //////////////////////////////////////////////////////////////////////////////////////////////////
+
+    // result related
+    size_t misses = 0;
+    size_t hits = 0;
+
+    // valid lines that were replaced by a miss and lines that are valid right now
+    size_t evictions = 0;
+    size_t validLines = 0;
+
+    // stream of the current request, set by the cache module before the access
+    unsigned stream = 0;
+
+    // false keeps only tags: no line data, no main memory and reads return 0
+    bool trackData = true;
+
+    // bytes fetched on a miss, less than cacheLineSize splits every line into sectors with their own valid bit
+    unsigned sectorSize = 0;
+    // fetches of the current request for a missing tag or only for a missing sector of a present line
+    unsigned lineFetches = 0, sectorFetches = 0;
+    size_t lineMisses = 0, sectorMisses = 0;
+
+    // one line per set, any number of lines is indexed by the bit slice (the line address modulo the lines)
+    BasicDirectMappedModel(unsigned cacheLineSize, unsigned offsetBitsCount, unsigned offsetBitsMask, uint32_t cacheLines) :
+    cacheLineSize(cacheLineSize), offsetBitsCount(offsetBitsCount), offsetBitsMask(offsetBitsMask),
+    indexHash(INDEX_BITSLICE, offsetBitsCount, cacheLines), setStatistics(cacheLines), streamStatistics(MAX_STREAMS),
+    sectorSize(cacheLineSize) {}
+
+    // valid bit of the sector holding offset
+    uint64_t sectorBit(unsigned offset) const {
+        return (uint64_t)1 << (offset / sectorSize);
+    }
+
+    uint64_t allSectors() const {
+        unsigned sectors = cacheLineSize / sectorSize;
+        return sectors >= 64 ? ~(uint64_t)0 : ((uint64_t)1 << sectors) - 1;
+    }
+
+    // updates cache and main memory for a write of size bytes, returns the number of lines fetched from main memory
+    unsigned writeData(Address addr, uint32_t data, unsigned size = 4) {
+        unsigned fetchedLines = 0;
+        fetchedLineAddresses.clear();
+        lineFetches = sectorFetches = 0;
+
+        // write 1 byte size times, an access touches every line it spans
+        for(unsigned i = 0; i < size; ++i) {
+            unsigned
+            offset = (addr + i) & offsetBitsMask,
+            index = indexHash.index(addr + i);
+            Tag tag = (Tag)indexHash.tag(addr + i);
+
+            CacheLine<Tag>& currentLine = cache[index];
+            uint64_t sector = sectorBit(offset);
+
+            if(!currentLine.valid || currentLine.tag != tag) { // cache miss
+
+                // writes the whole line so some bytes are written from main memory and then instantly rewritten again by the data input -> could be improved
+                // write the whole line from main memory / identical to read
+                if(trackData) {
+                    Address cacheLineAddr = addr ^ offsetBitsMask;
+                    for(unsigned j = 0; j < cacheLineSize; ++j) {
+                        currentLine.data[offset] = mainMemory[cacheLineAddr + j];
+                    }
+                }
+                
+                ++fetchedLines;
+                ++lineFetches;
+                fetchedLineAddresses.push_back((addr + i) & ~(uint64_t)(sectorSize - 1));
+                currentLine.valid ? ++evictions : ++validLines;
+                currentLine.valid = true; // could only be set if false -> could be improved (?)
+                currentLine.tag = tag; // "-"
+                currentLine.missingSectors = allSectors() & ~sector; // only the sector of the byte is fetched
+
+            } else if(currentLine.missingSectors & sector) { // sector miss, the line is present but not this sector
+                ++fetchedLines;
+                ++sectorFetches;
+                fetchedLineAddresses.push_back((addr + i) & ~(uint64_t)(sectorSize - 1));
+                currentLine.missingSectors &= ~sector;
+            }
+
+            if(trackData) {
+                uint8_t currentBlock = access_byte(data, size, i); // splitting the data into each of it's bytes, most significant first
+                currentLine.data[offset] = currentBlock;
+                mainMemory[addr + i] = currentBlock; // main memory access but could happen parallel due to hit
+            }
+        }
+
+        return fetchedLines;
+    }
+
+    // reads size bytes through the cache, returns the number of lines fetched from main memory
+    unsigned readData(Address addr, uint32_t& data, unsigned size = 4) {
+        unsigned fetchedLines = 0;
+        fetchedLineAddresses.clear();
+        lineFetches = sectorFetches = 0;
+        data = 0;
+
+        // read 1 byte size times, an access touches every line it spans
+        for(unsigned i = 0; i < size; ++i) {
+            unsigned
+            offset = (addr + i) & offsetBitsMask,
+            index = indexHash.index(addr + i);
+            Tag tag = (Tag)indexHash.tag(addr + i);
+
+            CacheLine<Tag>& currentLine = cache[index];
+            uint64_t sector = sectorBit(offset);
+
+            if(!currentLine.valid || currentLine.tag != tag) { // cache miss
+
+                // fetch the whole line from main memory / identical to write
+                if(trackData) {
+                    Address cacheLineAddr = addr ^ offsetBitsMask;
+                    for(unsigned j = 0; j < cacheLineSize; ++j) {
+                        currentLine.data[offset] = mainMemory[cacheLineAddr + j];
+                    }
+                }
+            
+                ++fetchedLines;
+                ++lineFetches;
+                fetchedLineAddresses.push_back((addr + i) & ~(uint64_t)(sectorSize - 1));
+                currentLine.valid ? ++evictions : ++validLines;
+                currentLine.valid = true; // could only be set if false -> could be improved (?)
+                currentLine.tag = tag; // "-"
+                currentLine.missingSectors = allSectors() & ~sector; // only the sector of the byte is fetched
+
+            } else if(currentLine.missingSectors & sector) { // sector miss, the line is present but not this sector
+                ++fetchedLines;
+                ++sectorFetches;
+                fetchedLineAddresses.push_back((addr + i) & ~(uint64_t)(sectorSize - 1));
+                currentLine.missingSectors &= ~sector;
+            }
+
+            if(trackData && access_byte_shift(size, i) < 32) {
+                data |= (uint32_t)currentLine.data[offset] << access_byte_shift(size, i); // read the cache block (either hit and no changes needed or newly fetched data)
+            }
+        }
+
+        return fetchedLines;
+    }
+
+    // counts a finished request for the result and the index of its first byte
+    void recordRequest(Address addr, unsigned fetchedLines, size_t cycles) {
+        bool isHit = fetchedLines == 0;
+        isHit ? ++hits : ++misses;
+
+        SetStatistics& statistics = setStatistics[indexHash.index(addr)];
+        statistics.accesses++;
+        statistics.hits += isHit;
+        statistics.misses += !isHit;
+        statistics.cycles += cycles;
+
+        SetStatistics& streamStatistic = streamStatistics[stream];
+        streamStatistic.accesses++;
+        streamStatistic.hits += isHit;
+        streamStatistic.misses += !isHit;
+        streamStatistic.cycles += cycles;
+
+        lineMisses += lineFetches;
+        sectorMisses += sectorFetches;
+    }
+
+    // functional warm-up: updates the cache state for a request without counting it
+    void warmUp(Request& request) {
+        stream = request.stream;
+        if(request.we) {
+            writeData(request.addr, request.data, request_size(&request));
+        } else {
+            readData(request.addr, request.data, request_size(&request));
+        }
+    }
+
+    // state snapshot: every used cache line followed by the main memory
+    void saveState(std::ostream& out) const {
+        writeSnapshotValue<uint64_t>(out, cache.size());
+        for(const auto& line : cache) {
+            writeSnapshotValue<uint32_t>(out, line.first);
+            writeSnapshotLine(out, line.second);
+        }
+        writeSnapshotBytes(out, mainMemory);
+    }
+
+    bool loadState(std::istream& in) {
+        uint64_t lines;
+        if(!readSnapshotValue(in, lines)) {
+            return false;
+        }
+        cache.clear();
+        for(uint64_t i = 0; i < lines; ++i) {
+            uint32_t index;
+            if(!readSnapshotValue(in, index) || !readSnapshotLine(in, cache[index])) {
+                return false;
+            }
+        }
+        validLines = 0;
+        for(const auto& line : cache) {
+            validLines += line.second.valid;
+        }
+        return readSnapshotBytes(in, mainMemory);
+    }
+};
+
+typedef BasicDirectMappedModel<uint32_t> DirectMappedModel;
+typedef BasicDirectMappedModel<uint64_t> WideDirectMappedModel;
+
+#endif
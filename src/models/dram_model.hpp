@@ -0,0 +1,105 @@
+#ifndef DRAM_MODEL_HPP
+#define DRAM_MODEL_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "../helper_structs/dram_config.h"
+
+/* Main memory timing with channels, ranks and banks that each have one row buffer.
+ * Every fetched line is a row buffer hit, miss or conflict depending on the row
+ * that the previous access left open in its bank. The caches fetch one line at a
+ * time, so the banks are never busy with overlapping accesses. */
+struct DramModel {
+
+    DramConfig config;
+
+    // address bits of the line offset, the column inside a row and every level of the organisation
+    unsigned lineBits = 0, columnBits = 0, channelBits = 0, rankBits = 0, bankBits = 0;
+
+    // open row of every bank in channel, rank, bank order
+    std::vector<uint64_t> openRow;
+    std::vector<bool> rowOpen;
+
+    // cycles every bank spent on fetching lines
+    std::vector<size_t> busyCycles;
+
+    // row buffer outcome of every fetched line
+    size_t rowHits = 0, rowMisses = 0, rowConflicts = 0;
+
+    DramModel(const DramConfig& config, unsigned cacheLineSize) :
+    config(config), lineBits(log2(cacheLineSize)), columnBits(log2(config.rowSize)),
+    channelBits(log2(config.channels)), rankBits(log2(config.ranks)), bankBits(log2(config.banks)),
+    openRow(banks()), rowOpen(banks()), busyCycles(banks()) {}
+
+    static unsigned log2(unsigned n) {
+        unsigned bits = 0;
+        while(n >>= 1) {
+            ++bits;
+        }
+        return bits;
+    }
+
+    // number of banks over all channels and ranks
+    unsigned banks() const {
+        return config.channels * config.ranks * config.banks;
+    }
+
+    // splits an address into its bank (over all channels and ranks) and row
+    void locate(uint64_t addr, unsigned& bank, uint64_t& row) const {
+        uint64_t bits;
+        if(config.mapping == DRAM_MAPPING_LINE) {
+            // the lines of a row are spread over all banks, the column bits above the line offset sit above them
+            bits = addr >> lineBits;
+        } else {
+            bits = addr >> columnBits;
+        }
+
+        unsigned bankIndex = bits & (config.banks - 1);
+        bits >>= bankBits;
+        unsigned rank = bits & (config.ranks - 1);
+        bits >>= rankBits;
+        unsigned channel = bits & (config.channels - 1);
+        bits >>= channelBits;
+
+        if(config.mapping == DRAM_MAPPING_LINE) {
+            bits >>= columnBits > lineBits ? columnBits - lineBits : 0;
+        }
+        row = bits;
+
+        if(config.mapping == DRAM_MAPPING_XOR) {
+            bankIndex ^= row & (config.banks - 1);
+        }
+
+        bank = (channel * config.ranks + rank) * config.banks + bankIndex;
+    }
+
+    // cycles for fetching the line at addr, updates the row buffer of its bank
+    unsigned fetchLine(uint64_t addr) {
+        unsigned bank;
+        uint64_t row;
+        locate(addr, bank, row);
+
+        unsigned latency;
+        if(!rowOpen[bank]) {
+            latency = config.rowMissLatency;
+            ++rowMisses;
+        } else if(openRow[bank] == row) {
+            latency = config.rowHitLatency;
+            ++rowHits;
+        } else {
+            latency = config.rowConflictLatency;
+            ++rowConflicts;
+        }
+
+        // with a closed page policy the bank is precharged right after the access
+        rowOpen[bank] = !config.closedPage;
+        openRow[bank] = row;
+        busyCycles[bank] += latency;
+
+        return latency;
+    }
+};
+
+#endif
@@ -0,0 +1,403 @@
+#ifndef FOUR_WAY_MODEL_HPP
+#define FOUR_WAY_MODEL_HPP
+
+#include <cstdint>
+#include <istream>
+#include <map>
+#include <ostream>
+#include <vector>
+
+#include "../helper_structs/request.h"
+#include "../helper_structs/cache_line.hpp"
+#include "../helper_structs/four_way_set.hpp"
+#include "../helper_structs/set_statistics.hpp"
+#include "../utils/snapshot.hpp"
+#include "../utils/tag_probe.hpp"
+#include "../utils/index_hash.hpp"
+
+/* State of the four-way cache and its main memory without any timing.
+ * Used by the pin-level FOURWAY_CACHE and the TLM target, which add the latencies.
+ * Address is the width of addresses and tags: FourWayModel compares four 32-bit tags
+ * in 16 bytes, WideFourWayModel keeps the 64-bit tags of traces above 4 GB. */
+template<typename Address>
+struct BasicFourWayModel {
+
+    typedef Address Tag;
+
+    /* Abstracting memory as a map. Each address (Address)
+     * is mapped to a byte (uint8_t). Default values are 0.*/
+    std::map<Address, uint8_t> mainMem;
+
+    /* Abstracting cache also as a map. Each set is mapped to its four ways
+     * with the tags stored next to each other for comparing them at once.
+     * Default values are empty sets.*/
+    std::map<uint32_t, FourWaySet<Tag>> cacheMem;
+
+    /* Hits, misses and cycles of every set, indexed by the set.
+     * A request is counted for the set of its first byte, with the skewed mapping for its set in way 0.*/
+    std::vector<SetStatistics> setStatistics;
+
+    // Hits, misses and cycles of every stream, indexed by the stream (MAX_STREAMS entries)
+    std::vector<SetStatistics> streamStatistics;
+
+    // Stream of the current request, set by the cache module before the access
+    unsigned stream = 0;
+
+    /* Ways every stream may fill on a miss (MAX_STREAMS masks, 0 = all ways), NULL without partitioning.
+     * Like way partitioning of a shared cache, lookups still hit in every way.*/
+    const unsigned* wayMasks = NULL;
+
+    unsigned cacheLineSize = 0, offsetBitsCount = 0, offsetBitMask = 0;
+
+    // Selects set and tag of an address, a bit slice unless another index function is chosen
+    IndexHash indexHash;
+
+    // Lines inserted so far, gives the FIFO order across the sets of the skewed mapping
+    size_t insertions = 0;
+
+    // Variables for counting hits and misses
+    size_t hits = 0, misses = 0;
+
+    // Valid lines replaced on a miss and the lines that are valid right now
+    size_t evictions = 0, validLines = 0;
+
+    // Variable used for determining cache hits or misses
+    bool foundInCache = false;
+
+    // Without data only tags and the FIFO order are kept, main memory isn't modelled and reads return 0
+    bool trackData = true;
+
+    /* Bytes fetched on a miss. Less than cacheLineSize splits every line into sectors with their own valid bit,
+     * a present line with a missing sector only fetches that sector.*/
+    unsigned sectorSize = 0;
+
+    // Fetches of the current request for a missing tag or only for a missing sector of a present line
+    unsigned lineFetches = 0, sectorFetches = 0;
+    size_t lineMisses = 0, sectorMisses = 0;
+
+    // Cache lines (or sectors) fetched from main memory during the current request
+    unsigned fetchedLines = 0;
+    std::vector<uint64_t> fetchedLineAddresses;
+
+    // Any number of sets is indexed by the bit slice, the line address modulo the sets
+    BasicFourWayModel(unsigned cacheLineSize, unsigned offsetBitsCount, unsigned offsetBitMask, uint32_t numberOfSets) :
+    setStatistics(numberOfSets), streamStatistics(MAX_STREAMS),
+    cacheLineSize(cacheLineSize), offsetBitsCount(offsetBitsCount), offsetBitMask(offsetBitMask),
+    indexHash(INDEX_BITSLICE, offsetBitsCount, numberOfSets), sectorSize(cacheLineSize) {}
+
+    // Valid bit of the sector holding address
+    uint64_t sectorBit(Address address) const {
+        return (uint64_t)1 << ((address & offsetBitMask) / sectorSize);
+    }
+
+    uint64_t allSectors() const {
+        unsigned sectors = cacheLineSize / sectorSize;
+        return sectors >= 64 ? ~(uint64_t)0 : ((uint64_t)1 << sectors) - 1;
+    }
+
+    // Fetching the sector starting at address from main memory into line
+    void fetchSector(CacheLine<Tag>& line, Address address) {
+        if(trackData) {
+            for(Address add = address; add < (address + sectorSize); add++) {
+                line.data[add & offsetBitMask] = mainMem[add];
+            }
+        }
+        line.missingSectors &= ~sectorBit(address);
+
+        // The memory latency is simulated by the caller for every fetched sector
+        ++fetchedLines;
+        fetchedLineAddresses.push_back(address);
+    }
+
+    // Ways the current stream may fill
+    unsigned allowedWays() const {
+        return wayMasks != NULL && wayMasks[stream] != 0 ? wayMasks[stream] & 0xF : 0xF;
+    }
+
+    // Valid ways of a set, with partitioning they don't have to be the first ways
+    unsigned validWays(const FourWaySet<Tag>& set) const {
+        if(wayMasks == NULL) {
+            return (1u << set.used) - 1;
+        }
+        unsigned valid = 0;
+        for(unsigned way = 0; way < 4; ++way) {
+            valid |= set.lines[way].valid ? 1u << way : 0;
+        }
+        return valid;
+    }
+
+    // Cache line holding address, NULL if it isn't cached
+    CacheLine<Tag>* findLine(Address address) {
+        Tag tag = (Tag)indexHash.tag(address);
+
+        // Every way is looked up in its own set
+        if(indexHash.function == INDEX_SKEWED) {
+            for(unsigned way = 0; way < 4; ++way) {
+                FourWaySet<Tag>& set = cacheMem[indexHash.index(address, way)];
+                if(set.lines[way].valid && set.tags[way] == tag) {
+                    return &set.lines[way];
+                }
+            }
+            return NULL;
+        }
+
+        // Comparing the tag with all valid ways of the set at once
+        FourWaySet<Tag>& set = cacheMem[indexHash.index(address)];
+        int way = findWay(set.tags, 4, validWays(set), tag);
+        return way >= 0 ? &set.lines[way] : NULL;
+    }
+
+    // Fetching cache block from main memory, only the sector starting at address with sectored lines
+    void addToCache(Address address) {
+        FourWaySet<Tag>* set = NULL;
+        unsigned way = 0;
+        unsigned allowed = allowedWays();
+
+        if(indexHash.function == INDEX_SKEWED) {
+            // The first empty way of the candidate sets, otherwise the oldest of their lines is replaced
+            for(unsigned w = 0; w < 4; ++w) {
+                if(!(allowed & (1u << w))) {
+                    continue;
+                }
+                FourWaySet<Tag>& candidate = cacheMem[indexHash.index(address, w)];
+                if(!candidate.lines[w].valid) {
+                    set = &candidate;
+                    way = w;
+                    break;
+                }
+                if(set == NULL || candidate.insertedAt[w] < set->insertedAt[way]) {
+                    set = &candidate;
+                    way = w;
+                }
+            }
+        } else if(wayMasks != NULL) {
+            // Partitioned: the first empty way of the stream, otherwise its oldest way is replaced
+            set = &cacheMem[indexHash.index(address)];
+            bool found = false;
+            for(unsigned w = 0; w < 4; ++w) {
+                if(!(allowed & (1u << w))) {
+                    continue;
+                }
+                if(!set->lines[w].valid) {
+                    way = w;
+                    found = true;
+                    break;
+                }
+                if(!found || set->insertedAt[w] < set->insertedAt[way]) {
+                    way = w;
+                    found = true;
+                }
+            }
+            set->used += !set->lines[way].valid;
+        } else {
+            // Finding which set should it mapped
+            set = &cacheMem[indexHash.index(address)];
+
+            /* If set is full (4 cache lines are present) the oldest way is replaced according to FIFO principals.
+             * Otherwise the next free way is used.*/
+            if(set->used >= 4) {
+                way = set->oldest;
+                set->oldest = (set->oldest + 1) % 4;
+            } else {
+                way = set->used++;
+            }
+        }
+
+        // Replacing a valid line is an eviction, filling an empty way adds to the occupancy
+        set->lines[way].valid ? ++evictions : ++validLines;
+
+        Tag tag = (Tag)indexHash.tag(address);
+        set->tags[way] = tag;
+        set->lines[way] = CacheLine<Tag> {.tag = tag, .valid = true, .missingSectors = allSectors()};
+        set->insertedAt[way] = ++insertions;
+
+        // Getting the cache block from main memory
+        ++lineFetches;
+        fetchSector(set->lines[way], address);
+    }
+
+    // Writing a byte to the cache. If not found fetch from main memory.
+    void writeByte(Address address, uint8_t val) {
+        uint32_t offset = address & offsetBitMask;
+        CacheLine<Tag>* line = findLine(address);
+
+        /*Because an operation can be unaligned, that's why
+         * it is used bitwise and operation for found boolean.
+         * If at least 1 byte can't be found the whole operation
+         * will be counted as miss.*/
+
+        // A present line with a missing sector only fetches that sector
+        if(line != NULL && (line->missingSectors & sectorBit(address))) {
+            ++sectorFetches;
+            fetchSector(*line, address & ~(Address)(sectorSize - 1));
+            foundInCache &= false;
+            return;
+        }
+
+        //If found then write the new data in according to cache cell.
+        if(line != NULL) {
+            if(trackData) {
+                line->data[offset] = val;
+            }
+            foundInCache &= true;
+            return;
+        }
+
+        // Not found in cache. Now fetch and update found boolean
+        addToCache(address & ~(Address)(sectorSize - 1));
+        foundInCache &= false;
+    }
+
+    // Reading byte from cache. If not found fetch from main memory.
+    uint8_t readByte(Address address) {
+        uint32_t offset = address & offsetBitMask;
+        CacheLine<Tag>* line = findLine(address);
+
+        /*Because an operation can be unaligned, that's why
+         * it is used bitwise and operation for found boolean.
+         * If at least 1 byte can't be found the whole operation
+         * will be counted as miss.*/
+
+        // A present line with a missing sector only fetches that sector
+        if(line != NULL && (line->missingSectors & sectorBit(address))) {
+            ++sectorFetches;
+            fetchSector(*line, address & ~(Address)(sectorSize - 1));
+            foundInCache &= false;
+            return trackData ? mainMem[address] : 0;
+        }
+
+        //If found then return the found data.
+        if(line != NULL) {
+            foundInCache &= true;
+            return trackData ? line->data[offset] : 0;
+        }
+
+        // Not found in cache. Now fetch from main memory, update the found boolean and return the wanted data.
+        addToCache(address & ~(Address)(sectorSize - 1));
+        foundInCache &= false;
+        return trackData ? mainMem[address] : 0;
+
+    }
+
+    // Writing the size bytes of d to the address a in main memory and cache, returns the number of fetched lines
+    unsigned writeData(Address a, uint32_t d, unsigned size = 4) {
+        // Must be true before operations because always used with bitwise and
+        foundInCache = true;
+        fetchedLines = 0;
+        fetchedLineAddresses.clear();
+        lineFetches = sectorFetches = 0;
+
+        /* Updating the values first because if cache miss then it fetches from main memory.
+         * If cache hits then the cpu can continue its process and writing to memory happens parallel
+         * so just cache latency. But for miss cache latency + memory latency*/
+        if(trackData) {
+            for(unsigned i = 0; i < size; ++i) {
+                mainMem[a+i] = access_byte(d, size, i);
+            }
+        }
+
+        // Writing to cache
+        for(unsigned i = 0; i < size; ++i) {
+            writeByte(a+i, access_byte(d, size, i));
+        }
+
+        return fetchedLines;
+    }
+
+    // Reading the size bytes at address a from cache into d, returns the number of fetched lines
+    unsigned readData(Address a, uint32_t& d, unsigned size = 4) {
+        // Must be true before operations because always used with bitwise and
+        foundInCache = true;
+        fetchedLines = 0;
+        fetchedLineAddresses.clear();
+        lineFetches = sectorFetches = 0;
+
+        // The bytes are read backwards, the last byte first
+        d = 0;
+        for(unsigned i = size; i-- > 0;) {
+            uint8_t byte = readByte(a+i);
+            if(access_byte_shift(size, i) < 32) {
+                d |= (uint32_t)byte << access_byte_shift(size, i);
+            }
+        }
+
+        return fetchedLines;
+    }
+
+    /* Counting a finished request for the result and for the set of its first byte.
+     * A request is a hit if none of its bytes had to be fetched.*/
+    void recordRequest(Address address, unsigned fetchedLines, size_t cycles) {
+        bool isHit = fetchedLines == 0;
+        isHit ? ++hits : ++misses;
+
+        SetStatistics& statistics = setStatistics[indexHash.index(address)];
+        statistics.accesses++;
+        statistics.hits += isHit;
+        statistics.misses += !isHit;
+        statistics.cycles += cycles;
+
+        SetStatistics& streamStatistic = streamStatistics[stream];
+        streamStatistic.accesses++;
+        streamStatistic.hits += isHit;
+        streamStatistic.misses += !isHit;
+        streamStatistic.cycles += cycles;
+
+        lineMisses += lineFetches;
+        sectorMisses += sectorFetches;
+    }
+
+    // Functional warm-up: updates cache and main memory for a request without counting it
+    void warmUp(Request& request) {
+        stream = request.stream;
+        if(request.we) {
+            writeData(request.addr, request.data, request_size(&request));
+        } else {
+            readData(request.addr, request.data, request_size(&request));
+        }
+    }
+
+    /* State snapshot: every used set with its cache lines in FIFO order,
+     * so the replacement order survives, followed by the main memory.*/
+    void saveState(std::ostream& out) const {
+        writeSnapshotValue<uint64_t>(out, cacheMem.size());
+        for(const auto& set : cacheMem) {
+            writeSnapshotValue<uint32_t>(out, set.first);
+            writeSnapshotValue<uint32_t>(out, set.second.used);
+            for(unsigned i = 0; i < set.second.used; ++i) {
+                writeSnapshotLine(out, set.second.lines[(set.second.oldest + i) % 4]);
+            }
+        }
+        writeSnapshotBytes(out, mainMem);
+    }
+
+    bool loadState(std::istream& in) {
+        uint64_t sets;
+        if(!readSnapshotValue(in, sets)) {
+            return false;
+        }
+        cacheMem.clear();
+        validLines = 0;
+        for(uint64_t i = 0; i < sets; ++i) {
+            uint32_t setIndex, lines;
+            if(!readSnapshotValue(in, setIndex) || !readSnapshotValue(in, lines) || lines > 4) {
+                return false;
+            }
+            // the oldest line comes first, so the ways are filled like by addToCache()
+            FourWaySet<Tag>& set = cacheMem[setIndex];
+            for(uint32_t way = 0; way < lines; ++way) {
+                if(!readSnapshotLine(in, set.lines[way])) {
+                    return false;
+                }
+                set.tags[way] = set.lines[way].tag;
+                set.used++;
+                validLines++;
+            }
+        }
+        return readSnapshotBytes(in, mainMem);
+    }
+};
+
+typedef BasicFourWayModel<uint32_t> FourWayModel;
+typedef BasicFourWayModel<uint64_t> WideFourWayModel;
+
+#endif
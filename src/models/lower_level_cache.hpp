@@ -0,0 +1,62 @@
+#ifndef LOWER_LEVEL_CACHE_HPP
+#define LOWER_LEVEL_CACHE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "../engine/functional_cache.hpp"
+
+/* Unified cache between the L1 caches and main memory, shared by all of them.
+ * It only sees the lines the L1 caches fetch, so it keeps tags without data. The
+ * write-through stores of the L1 caches pass it to main memory without allocating. */
+struct LowerLevelCache {
+    WideFunctionalCache cache;
+    unsigned cacheLineSize, latency;
+
+    size_t hits = 0, misses = 0;
+
+    // Lines of the last access that missed and have to come from main memory
+    std::vector<uint64_t> missedLines;
+
+    LowerLevelCache(bool directMapped, unsigned cacheLines, unsigned cacheLineSize, unsigned latency) :
+    cache(directMapped, log2(cacheLineSize), directMapped ? cacheLines : cacheLines / 4),
+    cacheLineSize(cacheLineSize), latency(latency) {}
+
+    static unsigned log2(unsigned n) {
+        unsigned bits = 0;
+        while(n > 1) {
+            n >>= 1;
+            bits++;
+        }
+        return bits;
+    }
+
+    // Looks up every own line covering the bytes of an upper level fetch and fills missedLines
+    void access(uint64_t address, unsigned bytes) {
+        missedLines.clear();
+        uint64_t first = address & ~(uint64_t)(cacheLineSize - 1);
+        uint64_t last = (address + bytes - 1) & ~(uint64_t)(cacheLineSize - 1);
+        for(uint64_t line = first; ; line += cacheLineSize) {
+            if(cache.accessByte(line)) {
+                ++misses;
+                missedLines.push_back(line);
+            } else {
+                ++hits;
+            }
+            if(line == last) {
+                break;
+            }
+        }
+    }
+
+    // Functional warm-up: updates the tags for an upper level fetch without counting it
+    void warmUp(uint64_t address, unsigned bytes) {
+        size_t countedHits = hits, countedMisses = misses;
+        access(address, bytes);
+        hits = countedHits;
+        misses = countedMisses;
+    }
+};
+
+#endif
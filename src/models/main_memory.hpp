@@ -0,0 +1,75 @@
+#ifndef MAIN_MEMORY_HPP
+#define MAIN_MEMORY_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "dram_model.hpp"
+#include "lower_level_cache.hpp"
+#include "memory_bus_model.hpp"
+
+/* Timing of the main memory behind a cache: the access latency of every line, flat or from
+ * the DRAM model, followed by its transfer over the memory bus if one is modelled. With a
+ * lower level cache a fetch first takes its latency and only its misses go to main memory.
+ * Shared by the pin-level and TLM caches, which only differ in how they wait. */
+struct MainMemoryTiming {
+
+    unsigned memoryLatency = 0, cacheLineSize = 0;
+
+    // bytes transferred per fetch, a sector instead of the whole line with sectored lines
+    unsigned fetchSize = 0;
+
+    // NULL for a flat memoryLatency per line and transfers without bandwidth limit
+    DramModel* dram = NULL;
+    MemoryBusModel* bus = NULL;
+    // NULL if the cache fetches straight from main memory
+    LowerLevelCache* lowerLevel = NULL;
+
+    MainMemoryTiming(unsigned memoryLatency, unsigned cacheLineSize) :
+    memoryLatency(memoryLatency), cacheLineSize(cacheLineSize), fetchSize(cacheLineSize) {}
+
+    // cycles from now until the given lines are fetched one after another
+    size_t fetchLines(size_t now, const std::vector<uint64_t>& lineAddresses) {
+        size_t done = now;
+        for(uint64_t addr : lineAddresses) {
+            if(lowerLevel != NULL) {
+                done += lowerLevel->latency;
+                lowerLevel->access(addr, fetchSize);
+                for(uint64_t line : lowerLevel->missedLines) {
+                    done = fetchFromMemory(done, line, lowerLevel->cacheLineSize);
+                }
+            } else {
+                done = fetchFromMemory(done, addr, fetchSize);
+            }
+        }
+        return done - now;
+    }
+
+    // time at which bytes from addr on arrive from main memory if the fetch starts at start
+    size_t fetchFromMemory(size_t start, uint64_t addr, unsigned bytes) {
+        size_t done = start + (dram != NULL ? dram->fetchLine(addr) : memoryLatency);
+        if(bus != NULL) {
+            done = bus->transfer(done, bytes);
+        }
+        return done;
+    }
+
+    // functional warm-up of the lower level with the lines the cache fetched, without timing
+    void warmUp(const std::vector<uint64_t>& lineAddresses) {
+        if(lowerLevel != NULL) {
+            for(uint64_t addr : lineAddresses) {
+                lowerLevel->warmUp(addr, fetchSize);
+            }
+        }
+    }
+
+    // write-through store of bytes, the cache doesn't wait for it but it occupies the bus
+    void postWrite(size_t now, unsigned bytes) {
+        if(bus != NULL) {
+            bus->transfer(now, bytes);
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,41 @@
+#ifndef MEMORY_BUS_MODEL_HPP
+#define MEMORY_BUS_MODEL_HPP
+
+#include <algorithm>
+#include <cstddef>
+
+/* Shared bus between cache and main memory that moves bytesPerCycle bytes per cycle.
+ * A transfer starts once its data is ready and the bus finished all earlier transfers,
+ * so line fills queue behind posted write-through stores and each other. */
+struct MemoryBusModel {
+
+    unsigned bytesPerCycle = 0;
+
+    // cycle at which the bus finishes its last accepted transfer
+    size_t busyUntil = 0;
+
+    // cycles spent moving data, cycles transfers waited for the bus and number of transfers
+    size_t busyCycles = 0, queueingCycles = 0, transfers = 0;
+
+    MemoryBusModel(unsigned bytesPerCycle) : bytesPerCycle(bytesPerCycle) {}
+
+    // cycles the bus is occupied by a transfer of bytes
+    size_t transferCycles(unsigned bytes) const {
+        return (bytes + bytesPerCycle - 1) / bytesPerCycle;
+    }
+
+    // queues a transfer of bytes that is ready at cycle ready, returns the cycle it is completed
+    size_t transfer(size_t ready, unsigned bytes) {
+        size_t start = std::max(ready, busyUntil);
+        size_t duration = transferCycles(bytes);
+
+        queueingCycles += start - ready;
+        busyCycles += duration;
+        ++transfers;
+
+        busyUntil = start + duration;
+        return busyUntil;
+    }
+};
+
+#endif
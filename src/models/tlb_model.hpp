@@ -0,0 +1,204 @@
+#ifndef TLB_MODEL_HPP
+#define TLB_MODEL_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <vector>
+
+#include "../helper_structs/request.h"
+#include "../helper_structs/tlb_config.h"
+
+/* Address translation ahead of the cache. The addresses of the trace are virtual and every
+ * page maps to the physical page of the same number, so only the timing of the translation
+ * is modelled: an L1 TLB hit is free, an L2 TLB hit takes its latency and a miss in both
+ * walks the page table. The page table is a radix tree of 4 KB tables with 512 entries of
+ * 8 bytes. For 32-bit traces it has 3 levels for 4 KB pages (2 for 2 MB pages) in the last
+ * 16 MB of the 32-bit address space. Traces with wider addresses walk 4 levels (3 for 2 MB
+ * pages) over the 48-bit virtual addresses of x86-64, with the tables above that range. */
+
+// Physical address of the root table of 32-bit traces, the tables of deeper levels follow it
+const uint64_t pageTableBase = 0xFF000000;
+
+// Physical address of the root table of wider traces, above the 47-bit user addresses, the deeper tables follow
+// in the order they are first walked
+const uint64_t widePageTableBase = 0xFFFF00000000;
+
+// Page number of an empty TLB entry, above every page number
+const uint64_t invalidTlbPage = UINT64_MAX;
+
+// One TLB level, set-associative with LRU replacement. The set of a page is its number modulo the sets.
+struct TlbLevel {
+    unsigned sets = 0, ways = 0;
+
+    // page number of every entry in set, way order, invalidTlbPage if the entry is empty
+    std::vector<uint64_t> pages;
+    std::vector<size_t> lastUse;
+    size_t useClock = 0;
+
+    TlbLevel() {}
+    TlbLevel(unsigned entries, unsigned ways) :
+    sets(entries / ways), ways(ways), pages(entries, invalidTlbPage), lastUse(entries, 0) {}
+
+    // Looks up page and makes it the most recently used entry of its set, false on a miss
+    bool lookup(uint64_t page) {
+        size_t first = (size_t)(page % sets) * ways;
+        for(size_t entry = first; entry < first + ways; ++entry) {
+            if(pages[entry] == page) {
+                lastUse[entry] = ++useClock;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Replaces an empty or else the least recently used entry of the set of page
+    void insert(uint64_t page) {
+        size_t first = (size_t)(page % sets) * ways;
+        size_t victim = first;
+        for(size_t entry = first; entry < first + ways; ++entry) {
+            if(pages[entry] == invalidTlbPage) {
+                victim = entry;
+                break;
+            }
+            if(lastUse[entry] < lastUse[victim]) {
+                victim = entry;
+            }
+        }
+        pages[victim] = page;
+        lastUse[victim] = ++useClock;
+    }
+};
+
+struct TlbModel {
+    TlbConfig config;
+    TlbLevel l1, l2;
+    unsigned pageBits;
+
+    // 4-level walks of addresses above 32 bits and the address of every table below the root, by level and prefix
+    bool wideAddresses;
+    std::map<uint64_t, uint64_t> wideTables;
+
+    // translations per outcome and the cycles the CPU stalled for L2 TLB hits and walks
+    size_t l1Hits = 0, l2Hits = 0, walks = 0, stallCycles = 0;
+    // page table reads of the walks that went through the cache
+    size_t walkRequests = 0;
+
+    TlbModel(const TlbConfig& config, bool wideAddresses = false) :
+    config(config), l1(config.l1Entries, config.l1Ways), pageBits(config.pageSize == TLB_PAGE_2M ? 21 : 12),
+    wideAddresses(wideAddresses) {
+        if(config.l2Entries > 0) {
+            l2 = TlbLevel(config.l2Entries, config.l2Ways);
+        }
+    }
+
+    // Physical addresses of the page table entries a walk for address reads, root first
+    std::vector<uint64_t> walkAddresses(uint64_t address) {
+        std::vector<uint64_t> entries;
+        if(wideAddresses) {
+            unsigned levels = pageBits == 12 ? 4 : 3;
+            uint64_t table = widePageTableBase;
+            for(unsigned level = 0; level < levels; ++level) {
+                unsigned shift = 39 - 9 * level;
+                entries.push_back(table + ((address >> shift) & 511) * 8);
+
+                // The virtual address bits from shift on select the table of the next level
+                if(level + 1 < levels) {
+                    uint64_t key = ((uint64_t)(level + 1) << 56) | ((address & 0xFFFFFFFFFFFF) >> shift);
+                    table = wideTables.emplace(key, widePageTableBase + (wideTables.size() + 1) * 4096).first->second;
+                }
+            }
+            return entries;
+        }
+
+        uint64_t rootIndex = (address >> 30) & 3;
+        uint64_t middleIndex = (address >> 21) & 511;
+
+        entries.push_back(pageTableBase + rootIndex * 8);
+        entries.push_back(pageTableBase + (1 + rootIndex) * 4096 + middleIndex * 8);
+        if(pageBits == 12) {
+            uint64_t table = 5 + ((rootIndex << 9) | middleIndex);
+            entries.push_back(pageTableBase + table * 4096 + ((address >> 12) & 511) * 8);
+        }
+        return entries;
+    }
+
+    /* Stall cycles of the translation of address. If the walk goes through the cache,
+     * walkReads gets the page table entries it reads, otherwise it stays empty. */
+    unsigned translate(uint64_t address, std::vector<uint64_t>& walkReads) {
+        uint64_t page = address >> pageBits;
+        walkReads.clear();
+
+        if(l1.lookup(page)) {
+            ++l1Hits;
+            return 0;
+        }
+
+        unsigned stall = 0;
+        if(l2.sets > 0) {
+            stall += config.l2Latency;
+            if(l2.lookup(page)) {
+                ++l2Hits;
+                l1.insert(page);
+                stallCycles += stall;
+                return stall;
+            }
+        }
+
+        ++walks;
+        stall += config.walkLatency;
+        if(config.walkThroughCache) {
+            walkReads = walkAddresses(address);
+            walkRequests += walkReads.size();
+        }
+        if(l2.sets > 0) {
+            l2.insert(page);
+        }
+        l1.insert(page);
+        stallCycles += stall;
+        return stall;
+    }
+};
+
+/* Trace for the cache behind the TLB: every request with the stall cycles of its translation
+ * added to its gap, preceded by the page table reads of its walk if they go through the cache.
+ * positions[i] is the index of requests[i] in the result and translatedWarmup the number of
+ * result requests before the first timed one. Only the timed requests count in the statistics. */
+inline std::vector<Request> translateRequests(TlbModel& tlb, const Request* requests, size_t numRequests,
+                                              size_t warmupCount, std::vector<size_t>& positions,
+                                              size_t& translatedWarmup) {
+    std::vector<Request> translated;
+    std::vector<uint64_t> walkReads;
+    positions.resize(numRequests);
+    translatedWarmup = 0;
+
+    for(size_t i = 0; i < numRequests; ++i) {
+        if(i == warmupCount) {
+            tlb.l1Hits = tlb.l2Hits = tlb.walks = tlb.stallCycles = tlb.walkRequests = 0;
+            translatedWarmup = translated.size();
+        }
+
+        Request request = requests[i];
+        unsigned stall = tlb.translate(request.addr, walkReads);
+
+        // The walk starts after the compute gap, the request right after the walk
+        for(size_t k = 0; k < walkReads.size(); ++k) {
+            Request read = {};
+            read.addr = walkReads[k];
+            read.size = 8;
+            read.stream = request.stream;
+            read.gap = k == 0 ? request.gap : 0;
+            translated.push_back(read);
+        }
+        request.gap = (walkReads.empty() ? request.gap : 0) + stall;
+
+        positions[i] = translated.size();
+        translated.push_back(request);
+    }
+    if(warmupCount >= numRequests) {
+        translatedWarmup = translated.size();
+    }
+    return translated;
+}
+
+#endif
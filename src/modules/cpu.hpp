@@ -10,8 +10,9 @@
 
 using namespace sc_core;
 
-// It's used for scheduling the requests to the cache
-SC_MODULE(CPU) {
+// It's used for scheduling the requests to the cache, Address is the width of the address signal
+template<typename Address>
+struct CPU : sc_module {
 
     // signals
     sc_in<bool> clk;
@@ -19,15 +20,20 @@ SC_MODULE(CPU) {
     sc_inout<bool> cache_ready;
 
     // Request signals
-    sc_out<sc_uint<32>> addr;
+    sc_out<sc_uint<8 * sizeof(Address)>> addr;
     sc_inout<sc_uint<32>> data;
     sc_out<int> we;
+    sc_out<unsigned> size;
+    sc_out<unsigned> stream;
 
     // Request related variables
     Request* requests;
     size_t numRequests;
     size_t currentRequest;
 
+    // Whether read data is written back into requests, off for timing only runs
+    bool writeBack = true;
+
     // Cycle related variables
     size_t maxCycles;
     size_t elapsedCycles;
@@ -39,7 +45,7 @@ SC_MODULE(CPU) {
 
 
     SC_CTOR(CPU);
-    CPU(sc_module_name name, size_t numRequests, Request* requests, int cycles) :
+    CPU(sc_module_name name, size_t numRequests, Request* requests, size_t cycles) :
     sc_module(name), numRequests(numRequests), requests(requests), maxCycles(cycles) {
 
         elapsedCycles = 0;
@@ -60,10 +66,25 @@ SC_MODULE(CPU) {
             // If cache ready send the next request
             if(cache_ready->read()) {
 
+                /* Compute cycles before the request: one timed wait to half a cycle before the
+                 * edge gap cycles later instead of waking up on every edge in between */
+                uint32_t gap = requests[currentRequest].gap;
+                if(gap > 0) {
+                    if(gap >= maxCycles - elapsedCycles) {
+                        break;
+                    }
+                    wait(sc_time(gap - 0.5, SC_NS));
+                    wait();
+                    elapsedCycles += gap;
+                    cycles->write(elapsedCycles);
+                }
+
                 // Writing request signals
                 addr->write(requests[currentRequest].addr);
                 data->write(requests[currentRequest].data);
                 we->write(requests[currentRequest].we);
+                size->write(request_size(&requests[currentRequest]));
+                stream->write(requests[currentRequest].stream);
 
                 // Telling cache that it sent a request
                 cache_ready->write(false);
@@ -79,7 +100,7 @@ SC_MODULE(CPU) {
             if(cache_ready->read()) {
 
                 // Update the data of the last request if it was a read operation
-                if(currentRequest > 0 && !requests[currentRequest - 1].we) {
+                if(writeBack && currentRequest > 0 && !requests[currentRequest - 1].we) {
                     requests[currentRequest - 1].data = data->read();
                 }
 
@@ -3,15 +3,19 @@
 
 #include <systemc>
 #include "systemc.h"
-#include <queue>
+#include <algorithm>
 #include <map>
 #include "../helper_structs/request.h"
 #include "../helper_structs/result.h"
-#include "../helper_structs/cache_line.hpp"
+#include "../models/four_way_model.hpp"
+#include "../models/main_memory.hpp"
+#include "../utils/interval_statistics.hpp"
 
 using namespace sc_core;
 
-SC_MODULE(FOURWAY_CACHE) {
+// Address is the width of the address signal and of the tags of the model
+template<typename Address>
+struct FOURWAY_CACHE : sc_module {
 
     // Used for letting cpu know that the current request is processed.
     sc_inout<bool> ready;
@@ -20,94 +24,55 @@ SC_MODULE(FOURWAY_CACHE) {
     sc_out<size_t> missCount, hitCount;
 
     // Signals coming from cpu
-    sc_in<sc_uint<32>> addr;
+    sc_in<sc_uint<8 * sizeof(Address)>> addr;
     sc_inout<sc_uint<32>> data;
     sc_in<int> we;
+    sc_in<unsigned> size;
+    sc_in<unsigned> stream;
 
-    /* Abstracting memory as a map. Each address (uint32_t)
-     * is mapped to a byte (uint8_t). Default values are 0.*/
-    std::map<uint32_t, uint8_t> mainMem;
+    unsigned cacheLatency = 0, memoryLatency = 0;
 
-    /* Abstracting cache also as a map. Each set
-     * is mapped to a deque which used for representing FIFO.
-     * Default values are empty FIFOs.*/
-    std::map<uint32_t, std::deque<CacheLine>> cacheMem;
+    // Cache and main memory contents, hit and miss counters
+    BasicFourWayModel<Address> model;
 
-    unsigned cacheLineSize = 0, cacheLatency = 0, memoryLatency = 0, setIndexBitsCount = 0, offsetBitsCount = 0, setIndexBitMask = 0, offsetBitMask = 0;
+    // Latency of every fetched line and the memory bus
+    MainMemoryTiming memoryTiming;
 
-    // Variables for counting hits and misses
-    size_t hits, misses;
-
-    // Variables used for easier bit selection
-    sc_uint<32> d;
-    sc_uint<32> a;
-
-    // Variable used for determining cache hits or misses
-    bool foundInCache = false;
+    // Time series of the counters, NULL if not recorded
+    IntervalStatistics* intervals = NULL;
 
     SC_CTOR(FOURWAY_CACHE);
     FOURWAY_CACHE(sc_module_name name, unsigned cacheLineSize, unsigned cacheLatency, unsigned memoryLatency,
-                  unsigned offsetBitsCount, unsigned offsetBitMask, unsigned setIndexBitsCount, unsigned setIndexBitMask):
-    sc_module(name), cacheLineSize(cacheLineSize), cacheLatency(cacheLatency), memoryLatency(memoryLatency),
-    offsetBitsCount(offsetBitsCount), offsetBitMask(offsetBitMask), setIndexBitsCount(setIndexBitsCount), setIndexBitMask(setIndexBitMask) {
-
-        hits = 0;
-        misses = 0;
+                  unsigned offsetBitsCount, unsigned offsetBitMask, uint32_t numberOfSets):
+    sc_module(name), cacheLatency(cacheLatency), memoryLatency(memoryLatency),
+    model(cacheLineSize, offsetBitsCount, offsetBitMask, numberOfSets),
+    memoryTiming(memoryLatency, cacheLineSize) {
 
         SC_THREAD(read);
         SC_THREAD(write);
 
     };
 
-    // Fetching cache block from main memory
-    void addToCache(uint32_t address) {
-        // Finding which set should it mapped
-        uint32_t setIndex = (address & setIndexBitMask) >> offsetBitsCount;
-        // If set is full (4 cache lines are present) remove the front cache line.
-        if(cacheMem[setIndex].size() >= 4) {
-            cacheMem[setIndex].pop_front();
-        }
-
-        // Adding the new cache line to the back of FIFO. Now the new cache line overwrites the old one according to FIFO principals.
-        cacheMem[setIndex].push_back(CacheLine {.tag = address >> (offsetBitsCount + setIndexBitsCount), .valid = true});
-
-        // Getting the cache block from main memory
-        for(uint32_t add = address; add < (address + cacheLineSize); add++) {
-            cacheMem[setIndex].back().data[add & offsetBitMask] = mainMem[add];
+    // Closing the intervals that ended before a request arriving at start
+    void advanceIntervals(sc_time start) {
+        if(intervals != NULL) {
+            intervals->advance(model, (size_t)(start / sc_time(1, SC_NS)));
         }
+    }
 
-        // Simulate the memory latency
-        wait(memoryLatency, SC_NS);
+    // Cycles of a request that arrived at start, the cpu charges every request at least one cycle
+    size_t requestCycles(sc_time start) {
+        return std::max<size_t>((size_t)((sc_time_stamp() - start) / sc_time(1, SC_NS)), 1);
     }
 
-    // Writing a byte to the cache. If not found fetch from main memory.
-    void writeByte(uint32_t address, uint8_t val) {
-        // Extracting the functional bits
-        uint32_t tag = address >> (offsetBitsCount + setIndexBitsCount);
-        uint32_t setIndex = (address & setIndexBitMask) >> offsetBitsCount;
-        uint32_t offset = address & offsetBitMask;
-
-        // Iterating every cache line in the set and look for the tag
-        for(CacheLine r : cacheMem[setIndex]) {
-            /*Because an operation can be unaligned, that's why
-             * it is used bitwise and operation for found boolean.
-             * If at least 1 byte can't be found the whole operation
-             * will be counted as miss.*/
-
-            //If found then write the new data in according to cache cell.
-            if(r.tag == tag) {
-                r.data[offset] = val;
-                foundInCache &= true;
-                return;
-            }
+    // Simulating the memory latency of every fetched line and the cache latency
+    void simulateLatency(unsigned fetchedLines) {
+        if(fetchedLines > 0) {
+            wait(memoryTiming.fetchLines((size_t)(sc_time_stamp() / sc_time(1, SC_NS)), model.fetchedLineAddresses), SC_NS);
         }
-
-        // Not found in cache. Now fetch and update found boolean
-        addToCache((address >> offsetBitsCount) << offsetBitsCount);
-        foundInCache &= false;
+        wait(cacheLatency, SC_NS);
     }
 
-
     // Will be called for every request and works if write enable 1 is.
     void write() {
         while (true) {
@@ -116,67 +81,26 @@ SC_MODULE(FOURWAY_CACHE) {
             // Check if request is a write operation
             if (we -> read()) {
 
-                // Using temp variables for bit selection
-                d = data -> read();
-                a = addr -> read();
+                Address a = addr -> read();
+                sc_time start = sc_time_stamp();
+                advanceIntervals(start);
 
-                // Must be true before operations because always used with bitwise and
-                foundInCache = true;
-
-                /* Updating the values first because if cache miss then it fetches from main memory.
-                 * If cache hits then the cpu can continue its process and writing to memory happens parallel
-                 * so just cache latency. But for miss cache latency + memory latency*/
-                mainMem[a] = d(31, 24);
-                mainMem[a+1] = d(23, 16);
-                mainMem[a+2] = d(15, 8);
-                mainMem[a+3] = d(7, 0);
-
-                // Writing to cache
-                writeByte(a, d(31, 24));
-                writeByte(a+1,d(23, 16));
-                writeByte(a+2,d(15, 8));
-                writeByte(a+3,d(7, 0));
-
-                // Simulating cache latency
-                wait(cacheLatency, SC_NS);
+                // Writing to main memory and cache, the write-through store goes over the bus without waiting
+                model.stream = stream -> read();
+                memoryTiming.postWrite((size_t)(start / sc_time(1, SC_NS)), size -> read());
+                unsigned fetchedLines = model.writeData(a, data -> read(), size -> read());
+                simulateLatency(fetchedLines);
 
                 // Writing to the signals
-                hitCount ->write(foundInCache ? ++hits:hits);
-                missCount ->write(foundInCache ? misses: ++misses);
+                model.recordRequest(a, fetchedLines, requestCycles(start));
+                hitCount ->write(model.hits);
+                missCount ->write(model.misses);
                 // Tell cpu that it's ready for the next request
                 ready ->write(true);
             }
         }
     }
 
-    // Reading byte from cache. If not found fetch from main memory.
-    uint8_t readByte(uint32_t address) {
-        // Extracting the functional bits
-        uint32_t tag = address >> (offsetBitsCount + setIndexBitsCount);
-        uint32_t setIndex = (address & setIndexBitMask) >> offsetBitsCount;
-        uint32_t offset = address & offsetBitMask;
-
-        // Iterating every cache line in the set and look for the tag
-        for(CacheLine r : cacheMem[setIndex]) {
-            /*Because an operation can be unaligned, that's why
-             * it is used bitwise and operation for found boolean.
-             * If at least 1 byte can't be found the whole operation
-             * will be counted as miss.*/
-
-            //If found then return the found data.
-            if(r.tag == tag) {
-                foundInCache &= true;
-                return r.data[offset];
-            }
-        }
-
-        // Not found in cache. Now fetch from main memory, update the found boolean and return the wanted data.
-        addToCache((address >> offsetBitsCount) << offsetBitsCount);
-        foundInCache &= false;
-        return mainMem[address];
-
-    }
-
     // Will be called for every request and works if write enable 0 is.
     void read() {
         while(true) {
@@ -185,27 +109,24 @@ SC_MODULE(FOURWAY_CACHE) {
             // Check if request is a read operation
             if (!we -> read()) {
 
-                // Using temp variables for bit selection
-                a = addr -> read();
-
-                // Must be true before operations because always used with bitwise and
-                foundInCache = true;
+                Address a = addr -> read();
+                uint32_t d;
+                sc_time start = sc_time_stamp();
+                advanceIntervals(start);
 
                 // Reading bytes from cache
-                d(7, 0) = readByte(a+3);
-                d(15, 8) = readByte(a+2);
-                d(23, 16) = readByte(a+1);
-                d(31, 24) = readByte(a);
+                model.stream = stream -> read();
+                unsigned fetchedLines = model.readData(a, d, size -> read());
 
                 // Send to cpu so it can updates the data section of request
                 data ->write(d);
 
-                // Simulate the cache latency
-                wait(cacheLatency, SC_NS);
+                simulateLatency(fetchedLines);
 
                 // Writing to signals
-                hitCount ->write(foundInCache ? ++hits: hits);
-                missCount ->write(foundInCache ? misses: ++misses);
+                model.recordRequest(a, fetchedLines, requestCycles(start));
+                hitCount ->write(model.hits);
+                missCount ->write(model.misses);
                 // Tell cpu that it's ready for the next request
                 ready ->write(true);
             }
@@ -0,0 +1,22 @@
+#ifndef STREAM_EXTENSION_HPP
+#define STREAM_EXTENSION_HPP
+
+#include <tlm>
+
+/* Stream (tenant) of a TLM transaction. The generic payload has no field for it, so the
+ * TLM CPU attaches this extension and the TLM cache reads it (stream 0 without it). */
+struct StreamExtension : tlm::tlm_extension<StreamExtension> {
+    unsigned stream = 0;
+
+    tlm::tlm_extension_base* clone() const override {
+        StreamExtension* extension = new StreamExtension;
+        extension->stream = stream;
+        return extension;
+    }
+
+    void copy_from(const tlm::tlm_extension_base& other) override {
+        stream = static_cast<const StreamExtension&>(other).stream;
+    }
+};
+
+#endif
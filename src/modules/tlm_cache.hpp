@@ -0,0 +1,93 @@
+#ifndef TLM_CACHE_HPP
+#define TLM_CACHE_HPP
+
+#include <systemc>
+#include "systemc.h"
+#include <tlm>
+#include <tlm_utils/simple_target_socket.h>
+#include <algorithm>
+
+#include "../models/main_memory.hpp"
+#include "../utils/interval_statistics.hpp"
+#include "stream_extension.hpp"
+
+using namespace sc_core;
+
+/* Loosely-timed target for either cache model (BasicDirectMappedModel or BasicFourWayModel of either address width).
+ * b_transport() does the access on the model right away and annotates the latency
+ * of the cache and every fetched line on the delay instead of waiting for it. */
+template<typename Model>
+struct TLM_CACHE : sc_module {
+
+    // Requests of the CPU arrive through this socket
+    tlm_utils::simple_target_socket<TLM_CACHE> socket;
+
+    unsigned cacheLatency = 0, memoryLatency = 0;
+
+    // Cache and main memory contents, hit and miss counters
+    Model model;
+
+    // Latency of every fetched line and the memory bus
+    MainMemoryTiming memoryTiming;
+
+    // Time series of the counters, NULL if not recorded
+    IntervalStatistics* intervals = NULL;
+
+    template<typename... ModelArguments>
+    TLM_CACHE(sc_module_name name, unsigned cacheLatency, unsigned memoryLatency, ModelArguments... modelArguments) :
+    sc_module(name), socket("socket"), cacheLatency(cacheLatency), memoryLatency(memoryLatency), model(modelArguments...),
+    memoryTiming(memoryLatency, model.cacheLineSize) {
+
+        socket.register_b_transport(this, &TLM_CACHE::b_transport);
+    }
+
+    void b_transport(tlm::tlm_generic_payload& transaction, sc_time& delay) {
+        // Like the pin-level caches only accesses of 1 to 64 bytes (powers of 2) without streaming are supported
+        unsigned size = transaction.get_data_length();
+        if(size == 0 || size > 64 || (size & (size - 1)) != 0 || transaction.get_streaming_width() != size) {
+            transaction.set_response_status(tlm::TLM_BURST_ERROR_RESPONSE);
+            return;
+        }
+        if(transaction.get_byte_enable_ptr() != NULL) {
+            transaction.set_response_status(tlm::TLM_BYTE_ENABLE_ERROR_RESPONSE);
+            return;
+        }
+
+        typename Model::Tag addr = transaction.get_address();
+        StreamExtension* streamExtension = transaction.get_extension<StreamExtension>();
+        model.stream = streamExtension != NULL ? streamExtension->stream : 0;
+        unsigned char* bytes = transaction.get_data_ptr();
+        uint32_t data = 0;
+        unsigned fetchedLines;
+
+        // The annotated time at which the request reaches the cache
+        size_t now = (size_t)((sc_time_stamp() + delay) / sc_time(1, SC_NS));
+        if(intervals != NULL) {
+            intervals->advance(model, now);
+        }
+
+        if(transaction.is_write()) {
+            memoryTiming.postWrite(now, size);
+            for(unsigned i = 0; i < size; ++i) {
+                if(access_byte_shift(size, i) < 32) {
+                    data |= (uint32_t)bytes[i] << access_byte_shift(size, i);
+                }
+            }
+            fetchedLines = model.writeData(addr, data, size);
+        } else {
+            fetchedLines = model.readData(addr, data, size);
+            for(unsigned i = 0; i < size; ++i) {
+                bytes[i] = access_byte(data, size, i);
+            }
+        }
+
+        size_t latency = cacheLatency + memoryTiming.fetchLines(now, model.fetchedLineAddresses);
+        // Like the CPU the statistics count at least one cycle per request
+        model.recordRequest(addr, fetchedLines, std::max<size_t>(latency, 1));
+        delay += sc_time(latency, SC_NS);
+
+        transaction.set_response_status(tlm::TLM_OK_RESPONSE);
+    }
+};
+
+#endif
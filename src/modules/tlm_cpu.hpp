@@ -0,0 +1,136 @@
+#ifndef TLM_CPU_HPP
+#define TLM_CPU_HPP
+
+#include <systemc>
+#include "systemc.h"
+#include <tlm>
+#include <tlm_utils/simple_initiator_socket.h>
+#include <tlm_utils/tlm_quantumkeeper.h>
+#include <algorithm>
+#include <memory>
+
+// helper structs
+#include "../helper_structs/request.h"
+
+#include "stream_extension.hpp"
+
+using namespace sc_core;
+
+/* Loosely-timed counterpart of CPU. Every request is one blocking b_transport() call
+ * instead of a handshake over signals. With temporal decoupling the CPU runs ahead of
+ * the simulation time by up to one global quantum and only synchronizes with the
+ * SystemC kernel when the quantum is used up. */
+SC_MODULE(TLM_CPU) {
+
+    // Requests go to the cache through this socket
+    tlm_utils::simple_initiator_socket<TLM_CPU> socket;
+
+    // Instruction fetches go to the instruction cache through this socket with a split L1, NULL otherwise
+    std::unique_ptr<tlm_utils::simple_initiator_socket<TLM_CPU>> fetchSocket;
+
+    // Request related variables
+    Request* requests;
+    size_t numRequests;
+
+    // Whether read data is written back into requests, off for timing only runs
+    bool writeBack = true;
+
+    // Cycle related variables
+    size_t maxCycles;
+
+    // Only result that comes from the CPU, SIZE_MAX if not all requests finished within maxCycles
+    size_t cycles = 0;
+
+    // Local time offset of the CPU against the simulation time
+    tlm_utils::tlm_quantumkeeper quantumKeeper;
+
+    SC_CTOR(TLM_CPU);
+    TLM_CPU(sc_module_name name, size_t numRequests, Request* requests, size_t cycles, bool splitCache = false) :
+    sc_module(name), socket("socket"), requests(requests), numRequests(numRequests), maxCycles(cycles) {
+
+        if(splitCache) {
+            fetchSocket.reset(new tlm_utils::simple_initiator_socket<TLM_CPU>("fetch_socket"));
+        }
+
+        quantumKeeper.reset();
+
+        SC_THREAD(run);
+    }
+
+    void run() {
+        tlm::tlm_generic_payload transaction;
+        StreamExtension streamExtension;
+        transaction.set_extension(&streamExtension);
+        unsigned char bytes[64];
+        size_t elapsedCycles = 0;
+        size_t currentRequest;
+
+        for(currentRequest = 0; currentRequest < numRequests; ++currentRequest) {
+            Request& request = requests[currentRequest];
+
+            // The bytes in address order, the most significant byte of data belongs to addr
+            unsigned size = request_size(&request);
+            for(unsigned i = 0; i < size; ++i) {
+                bytes[i] = access_byte(request.data, size, i);
+            }
+
+            transaction.set_command(request.we ? tlm::TLM_WRITE_COMMAND : tlm::TLM_READ_COMMAND);
+            transaction.set_address(request.addr);
+            transaction.set_data_ptr(bytes);
+            transaction.set_data_length(size);
+            transaction.set_streaming_width(size);
+            transaction.set_byte_enable_ptr(NULL);
+            transaction.set_dmi_allowed(false);
+            transaction.set_response_status(tlm::TLM_INCOMPLETE_RESPONSE);
+            streamExtension.stream = request.stream;
+
+            // Compute cycles before the request only advance the local time
+            if(request.gap > maxCycles - elapsedCycles) {
+                break;
+            }
+            elapsedCycles += request.gap;
+            quantumKeeper.inc(sc_time(request.gap, SC_NS));
+
+            // The cache annotates its latency on top of the local time
+            sc_time localTime = quantumKeeper.get_local_time();
+            sc_time delay = localTime;
+            tlm_utils::simple_initiator_socket<TLM_CPU>& target = request.fetch && fetchSocket ? *fetchSocket : socket;
+            target->b_transport(transaction, delay);
+
+            if(transaction.is_response_error()) {
+                SC_REPORT_ERROR(name(), transaction.get_response_string().c_str());
+            }
+
+            // Like the clocked CPU a request takes at least one cycle
+            size_t latency = std::max<size_t>((size_t)((delay - localTime) / sc_time(1, SC_NS)), 1);
+            if(latency > maxCycles - elapsedCycles) {
+                break;
+            }
+            elapsedCycles += latency;
+            quantumKeeper.set(localTime + sc_time(latency, SC_NS));
+
+            // Update the data of the request if it was a read operation
+            if(writeBack && !request.we) {
+                request.data = 0;
+                for(unsigned i = 0; i < size; ++i) {
+                    if(access_byte_shift(size, i) < 32) {
+                        request.data |= (uint32_t)bytes[i] << access_byte_shift(size, i);
+                    }
+                }
+            }
+
+            if(quantumKeeper.need_sync()) {
+                quantumKeeper.sync();
+            }
+        }
+        quantumKeeper.sync();
+
+        // The payload would delete its extensions, this one lives on the stack
+        transaction.clear_extension(&streamExtension);
+
+        // Cache has not processed all requests within the cycles -> not finished
+        cycles = currentRequest < numRequests ? SIZE_MAX : elapsedCycles;
+    }
+};
+
+#endif
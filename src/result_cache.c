@@ -0,0 +1,309 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "result_cache.h"
+
+/* Part of every key and stored result. Has to be increased whenever a change of
+ * the simulation changes its results, so that older results aren't returned anymore. */
+#define RESULT_CACHE_VERSION 9
+
+static const char resultCacheMagic[4] = {'C', 'R', 'E', 'S'};
+
+/*
+ * XXH64 (https://github.com/Cyan4973/xxHash/blob/dev/doc/xxhash_spec.md)
+ */
+
+#define PRIME64_1 0x9E3779B185EBCA87ULL
+#define PRIME64_2 0xC2B2AE3D27D4EB4FULL
+#define PRIME64_3 0x165667B19E3779F9ULL
+#define PRIME64_4 0x85EBCA77C2B2AE63ULL
+#define PRIME64_5 0x27D4EB2F165667C5ULL
+
+static uint64_t rotate_left(uint64_t value, int bits) {
+    return (value << bits) | (value >> (64 - bits));
+}
+
+// Little endian reads of unaligned input
+static uint64_t read64(const uint8_t *p) {
+    uint64_t value = 0;
+    for (int i = 7; i >= 0; i--) {
+        value = (value << 8) | p[i];
+    }
+    return value;
+}
+
+static uint32_t read32(const uint8_t *p) {
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static uint64_t xxh64_round(uint64_t accumulator, uint64_t input) {
+    accumulator += input * PRIME64_2;
+    accumulator = rotate_left(accumulator, 31);
+    return accumulator * PRIME64_1;
+}
+
+static uint64_t xxh64_merge(uint64_t accumulator, uint64_t value) {
+    accumulator ^= xxh64_round(0, value);
+    return accumulator * PRIME64_1 + PRIME64_4;
+}
+
+static uint64_t xxh64(const void *input, size_t length, uint64_t seed) {
+    const uint8_t *p = (const uint8_t *)input;
+    const uint8_t *end = p + length;
+    uint64_t hash;
+
+    if (length >= 32) {
+        uint64_t v1 = seed + PRIME64_1 + PRIME64_2;
+        uint64_t v2 = seed + PRIME64_2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed - PRIME64_1;
+
+        // 32 byte stripes in four independent lanes
+        do {
+            v1 = xxh64_round(v1, read64(p));
+            v2 = xxh64_round(v2, read64(p + 8));
+            v3 = xxh64_round(v3, read64(p + 16));
+            v4 = xxh64_round(v4, read64(p + 24));
+            p += 32;
+        } while (end - p >= 32);
+
+        hash = rotate_left(v1, 1) + rotate_left(v2, 7) + rotate_left(v3, 12) + rotate_left(v4, 18);
+        hash = xxh64_merge(hash, v1);
+        hash = xxh64_merge(hash, v2);
+        hash = xxh64_merge(hash, v3);
+        hash = xxh64_merge(hash, v4);
+    } else {
+        hash = seed + PRIME64_5;
+    }
+
+    hash += length;
+
+    for (; end - p >= 8; p += 8) {
+        hash ^= xxh64_round(0, read64(p));
+        hash = rotate_left(hash, 27) * PRIME64_1 + PRIME64_4;
+    }
+    if (end - p >= 4) {
+        hash ^= (uint64_t)read32(p) * PRIME64_1;
+        hash = rotate_left(hash, 23) * PRIME64_2 + PRIME64_3;
+        p += 4;
+    }
+    for (; p < end; p++) {
+        hash ^= *p * PRIME64_5;
+        hash = rotate_left(hash, 11) * PRIME64_1;
+    }
+
+    // avalanche
+    hash ^= hash >> 33;
+    hash *= PRIME64_2;
+    hash ^= hash >> 29;
+    hash *= PRIME64_3;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+int result_cache_key(const char *tracePath, const uint64_t *parameters, size_t parameterCount, uint64_t *key) {
+    int fd = open(tracePath, O_RDONLY);
+    struct stat info;
+    if (fd < 0 || fstat(fd, &info) != 0) {
+        fprintf(stderr, "Error opening file %s: %s\n", tracePath, strerror(errno));
+        if (fd >= 0) {
+            close(fd);
+        }
+        return 1;
+    }
+
+    // The trace is hashed straight from the page cache without copying it
+    uint64_t traceHash = xxh64(NULL, 0, RESULT_CACHE_VERSION);
+    if (info.st_size > 0) {
+        void *contents = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (contents == MAP_FAILED) {
+            fprintf(stderr, "Error mapping file %s: %s\n", tracePath, strerror(errno));
+            close(fd);
+            return 1;
+        }
+        traceHash = xxh64(contents, info.st_size, RESULT_CACHE_VERSION);
+        munmap(contents, info.st_size);
+    }
+    close(fd);
+
+    // Parameters as little endian bytes, so the key doesn't depend on the host
+    uint8_t *bytes = (uint8_t *)malloc(parameterCount * 8 + 1);
+    if (bytes == NULL) {
+        fprintf(stderr, "No space in memory: %s\n", strerror(errno));
+        return 1;
+    }
+    for (size_t i = 0; i < parameterCount; i++) {
+        for (int j = 0; j < 8; j++) {
+            bytes[i * 8 + j] = (uint8_t)(parameters[i] >> (8 * j));
+        }
+    }
+    *key = xxh64(bytes, parameterCount * 8, traceHash);
+    free(bytes);
+    return 0;
+}
+
+static void result_path(char *path, size_t size, const char *directory, uint64_t key) {
+    snprintf(path, size, "%s/%016llx.result", directory, (unsigned long long)key);
+}
+
+int result_cache_load(const char *directory, uint64_t key, struct Result *result) {
+    char path[PATH_MAX];
+    result_path(path, sizeof(path), directory, key);
+
+    FILE *fp = fopen(path, "rb");
+    if (!fp) {
+        return 1;
+    }
+
+    char magic[sizeof(resultCacheMagic)];
+    uint32_t version;
+    uint64_t storedKey;
+    memset(result, 0, sizeof(*result));
+
+    int valid = fread(magic, sizeof(magic), 1, fp) == 1 && memcmp(magic, resultCacheMagic, sizeof(magic)) == 0
+                && fread(&version, sizeof(version), 1, fp) == 1 && version == RESULT_CACHE_VERSION
+                && fread(&storedKey, sizeof(storedKey), 1, fp) == 1 && storedKey == key
+                && fread(&result->cycles, sizeof(result->cycles), 1, fp) == 1
+                && fread(&result->misses, sizeof(result->misses), 1, fp) == 1
+                && fread(&result->hits, sizeof(result->hits), 1, fp) == 1
+                && fread(&result->primitiveGateCount, sizeof(result->primitiveGateCount), 1, fp) == 1
+                && fread(&result->sampledRequests, sizeof(result->sampledRequests), 1, fp) == 1
+                && fread(&result->timedRequests, sizeof(result->timedRequests), 1, fp) == 1
+                && fread(&result->cyclesMargin, sizeof(result->cyclesMargin), 1, fp) == 1
+                && fread(&result->missesMargin, sizeof(result->missesMargin), 1, fp) == 1
+                && fread(&result->hitsMargin, sizeof(result->hitsMargin), 1, fp) == 1
+                && fread(&result->validatedRequests, sizeof(result->validatedRequests), 1, fp) == 1
+                && fread(&result->rowHits, sizeof(result->rowHits), 1, fp) == 1
+                && fread(&result->rowMisses, sizeof(result->rowMisses), 1, fp) == 1
+                && fread(&result->rowConflicts, sizeof(result->rowConflicts), 1, fp) == 1
+                && fread(&result->busTransfers, sizeof(result->busTransfers), 1, fp) == 1
+                && fread(&result->busBusyCycles, sizeof(result->busBusyCycles), 1, fp) == 1
+                && fread(&result->busQueueingCycles, sizeof(result->busQueueingCycles), 1, fp) == 1
+                && fread(&result->sets, sizeof(result->sets), 1, fp) == 1
+                && fread(&result->usedSets, sizeof(result->usedSets), 1, fp) == 1
+                && fread(&result->maxSetAccesses, sizeof(result->maxSetAccesses), 1, fp) == 1
+                && fread(&result->setAccessVariation, sizeof(result->setAccessVariation), 1, fp) == 1
+                && fread(&result->indexHashGateCount, sizeof(result->indexHashGateCount), 1, fp) == 1
+                && fread(&result->lineMisses, sizeof(result->lineMisses), 1, fp) == 1
+                && fread(&result->sectorMisses, sizeof(result->sectorMisses), 1, fp) == 1
+                && fread(&result->fetchedBytes, sizeof(result->fetchedBytes), 1, fp) == 1
+                && fread(&result->instructionHits, sizeof(result->instructionHits), 1, fp) == 1
+                && fread(&result->instructionMisses, sizeof(result->instructionMisses), 1, fp) == 1
+                && fread(&result->lowerLevelHits, sizeof(result->lowerLevelHits), 1, fp) == 1
+                && fread(&result->lowerLevelMisses, sizeof(result->lowerLevelMisses), 1, fp) == 1
+                && fread(&result->tlbHits, sizeof(result->tlbHits), 1, fp) == 1
+                && fread(&result->tlbL2Hits, sizeof(result->tlbL2Hits), 1, fp) == 1
+                && fread(&result->tlbWalks, sizeof(result->tlbWalks), 1, fp) == 1
+                && fread(&result->tlbStallCycles, sizeof(result->tlbStallCycles), 1, fp) == 1
+                && fread(&result->walkRequests, sizeof(result->walkRequests), 1, fp) == 1
+                && fread(&result->banks, sizeof(result->banks), 1, fp) == 1;
+
+    // Busy cycles of every bank, allocated like by the simulation
+    if (valid && result->banks > 0) {
+        result->bankBusyCycles = (size_t *)malloc(sizeof(size_t) * result->banks);
+        valid = result->bankBusyCycles != NULL
+                && fread(result->bankBusyCycles, sizeof(size_t), result->banks, fp) == result->banks;
+    }
+
+    // Statistics of every stream, allocated like by the simulation
+    valid = valid && fread(&result->streams, sizeof(result->streams), 1, fp) == 1;
+    if (valid && result->streams > 0) {
+        result->streamHits = (size_t *)malloc(sizeof(size_t) * result->streams);
+        result->streamMisses = (size_t *)malloc(sizeof(size_t) * result->streams);
+        result->streamCycles = (size_t *)malloc(sizeof(size_t) * result->streams);
+        valid = result->streamHits != NULL && result->streamMisses != NULL && result->streamCycles != NULL
+                && fread(result->streamHits, sizeof(size_t), result->streams, fp) == result->streams
+                && fread(result->streamMisses, sizeof(size_t), result->streams, fp) == result->streams
+                && fread(result->streamCycles, sizeof(size_t), result->streams, fp) == result->streams;
+    }
+    fclose(fp);
+
+    if (!valid) {
+        free(result->bankBusyCycles);
+        free(result->streamHits);
+        free(result->streamMisses);
+        free(result->streamCycles);
+        memset(result, 0, sizeof(*result));
+        return 1;
+    }
+    return 0;
+}
+
+void result_cache_store(const char *directory, uint64_t key, const struct Result *result) {
+    char path[PATH_MAX];
+    char temporaryPath[PATH_MAX + 32];
+    uint32_t version = RESULT_CACHE_VERSION;
+
+    if (mkdir(directory, 0777) != 0 && errno != EEXIST) {
+        fprintf(stderr, "Warning: can't create result cache %s: %s\n", directory, strerror(errno));
+        return;
+    }
+
+    // Written under a private name and renamed, so concurrent runs never read a partial result
+    result_path(path, sizeof(path), directory, key);
+    snprintf(temporaryPath, sizeof(temporaryPath), "%s.%ld.tmp", path, (long)getpid());
+
+    FILE *fp = fopen(temporaryPath, "wb");
+    if (!fp) {
+        fprintf(stderr, "Warning: can't write result cache %s: %s\n", temporaryPath, strerror(errno));
+        return;
+    }
+
+    int written = fwrite(resultCacheMagic, sizeof(resultCacheMagic), 1, fp) == 1
+                  && fwrite(&version, sizeof(version), 1, fp) == 1
+                  && fwrite(&key, sizeof(key), 1, fp) == 1
+                  && fwrite(&result->cycles, sizeof(result->cycles), 1, fp) == 1
+                  && fwrite(&result->misses, sizeof(result->misses), 1, fp) == 1
+                  && fwrite(&result->hits, sizeof(result->hits), 1, fp) == 1
+                  && fwrite(&result->primitiveGateCount, sizeof(result->primitiveGateCount), 1, fp) == 1
+                  && fwrite(&result->sampledRequests, sizeof(result->sampledRequests), 1, fp) == 1
+                  && fwrite(&result->timedRequests, sizeof(result->timedRequests), 1, fp) == 1
+                  && fwrite(&result->cyclesMargin, sizeof(result->cyclesMargin), 1, fp) == 1
+                  && fwrite(&result->missesMargin, sizeof(result->missesMargin), 1, fp) == 1
+                  && fwrite(&result->hitsMargin, sizeof(result->hitsMargin), 1, fp) == 1
+                  && fwrite(&result->validatedRequests, sizeof(result->validatedRequests), 1, fp) == 1
+                  && fwrite(&result->rowHits, sizeof(result->rowHits), 1, fp) == 1
+                  && fwrite(&result->rowMisses, sizeof(result->rowMisses), 1, fp) == 1
+                  && fwrite(&result->rowConflicts, sizeof(result->rowConflicts), 1, fp) == 1
+                  && fwrite(&result->busTransfers, sizeof(result->busTransfers), 1, fp) == 1
+                  && fwrite(&result->busBusyCycles, sizeof(result->busBusyCycles), 1, fp) == 1
+                  && fwrite(&result->busQueueingCycles, sizeof(result->busQueueingCycles), 1, fp) == 1
+                  && fwrite(&result->sets, sizeof(result->sets), 1, fp) == 1
+                  && fwrite(&result->usedSets, sizeof(result->usedSets), 1, fp) == 1
+                  && fwrite(&result->maxSetAccesses, sizeof(result->maxSetAccesses), 1, fp) == 1
+                  && fwrite(&result->setAccessVariation, sizeof(result->setAccessVariation), 1, fp) == 1
+                  && fwrite(&result->indexHashGateCount, sizeof(result->indexHashGateCount), 1, fp) == 1
+                  && fwrite(&result->lineMisses, sizeof(result->lineMisses), 1, fp) == 1
+                  && fwrite(&result->sectorMisses, sizeof(result->sectorMisses), 1, fp) == 1
+                  && fwrite(&result->fetchedBytes, sizeof(result->fetchedBytes), 1, fp) == 1
+                  && fwrite(&result->instructionHits, sizeof(result->instructionHits), 1, fp) == 1
+                  && fwrite(&result->instructionMisses, sizeof(result->instructionMisses), 1, fp) == 1
+                  && fwrite(&result->lowerLevelHits, sizeof(result->lowerLevelHits), 1, fp) == 1
+                  && fwrite(&result->lowerLevelMisses, sizeof(result->lowerLevelMisses), 1, fp) == 1
+                  && fwrite(&result->tlbHits, sizeof(result->tlbHits), 1, fp) == 1
+                  && fwrite(&result->tlbL2Hits, sizeof(result->tlbL2Hits), 1, fp) == 1
+                  && fwrite(&result->tlbWalks, sizeof(result->tlbWalks), 1, fp) == 1
+                  && fwrite(&result->tlbStallCycles, sizeof(result->tlbStallCycles), 1, fp) == 1
+                  && fwrite(&result->walkRequests, sizeof(result->walkRequests), 1, fp) == 1
+                  && fwrite(&result->banks, sizeof(result->banks), 1, fp) == 1
+                  && (result->banks == 0
+                      || fwrite(result->bankBusyCycles, sizeof(size_t), result->banks, fp) == result->banks)
+                  && fwrite(&result->streams, sizeof(result->streams), 1, fp) == 1
+                  && (result->streams == 0
+                      || (fwrite(result->streamHits, sizeof(size_t), result->streams, fp) == result->streams
+                          && fwrite(result->streamMisses, sizeof(size_t), result->streams, fp) == result->streams
+                          && fwrite(result->streamCycles, sizeof(size_t), result->streams, fp) == result->streams));
+
+    if (fclose(fp) != 0 || !written || rename(temporaryPath, path) != 0) {
+        fprintf(stderr, "Warning: can't write result cache %s: %s\n", path, strerror(errno));
+        unlink(temporaryPath);
+    }
+}
@@ -0,0 +1,22 @@
+#ifndef RESULT_CACHE_H
+#define RESULT_CACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "helper_structs/result.h"
+
+/* On-disk store of simulation results, one file per key in a shared directory.
+ * The key is the XXH64 hash of the trace contents combined with every parameter
+ * that influences the result, so identical runs are only simulated once. */
+
+// Hashes the trace file and the parameters into key, returns 1 if the trace can't be read
+int result_cache_key(const char *tracePath, const uint64_t *parameters, size_t parameterCount, uint64_t *key);
+
+// Reads the stored result of key, returns 1 if there is none or it is unreadable
+int result_cache_load(const char *directory, uint64_t key, struct Result *result);
+
+// Persists the result of key, failures are only reported on stderr
+void result_cache_store(const char *directory, uint64_t key, const struct Result *result);
+
+#endif
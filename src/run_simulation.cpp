@@ -1,62 +1,194 @@
 #include <systemc>
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <memory>
+#include <vector>
 
 // modules
 #include "modules/cpu.hpp"
 #include "modules/direct_mapped_cache.hpp"
 #include "modules/four_way_cache.hpp"
+#include "modules/tlm_cpu.hpp"
+#include "modules/tlm_cache.hpp"
 
 // helper structs
 #include "helper_structs/request.h"
 #include "helper_structs/result.h"
+#include "helper_structs/options.h"
+#include "helper_structs/cache_config.h"
 
-/* Self created logarithm without using double or float
- * so that narrowing conversation never happens. */
-unsigned log2(unsigned a) {
-    unsigned digits = 0;
-    while (a > 1) {
-        a >>= 1;
-        digits++;
+// engines without SystemC
+#include "engine/multi_simulation.hpp"
+#include "engine/parallel_simulation.hpp"
+#include "engine/chunked_simulation.hpp"
+#include "engine/trace_filter.hpp"
+
+// models without a SystemC module
+#include "models/tlb_model.hpp"
+
+// utils
+#include "utils/set_sampling.hpp"
+#include "utils/snapshot.hpp"
+#include "utils/gate_count.hpp"
+#include "utils/interval_statistics.hpp"
+
+/* Writes the snapshot header and the state of the given cache module.
+ * The header holds the geometry and the width of the tags and main memory addresses.
+ * Exits the program if the file can't be written. */
+template<typename Cache>
+void saveSnapshot(const char* filename, const Cache& cache, int directMapped, unsigned cacheLines, unsigned cacheLineSize) {
+    std::ofstream out(filename, std::ios::binary);
+    out.write(snapshotMagic, sizeof(snapshotMagic));
+    writeSnapshotValue<uint32_t>(out, snapshotVersion);
+    writeSnapshotValue<uint8_t>(out, directMapped ? 1 : 0);
+    writeSnapshotValue<uint32_t>(out, cacheLines);
+    writeSnapshotValue<uint32_t>(out, cacheLineSize);
+    writeSnapshotValue<uint8_t>(out, 8 * sizeof(typename Cache::Tag));
+    cache.saveState(out);
+
+    if(!out) {
+        std::cerr << "Error writing state snapshot " << filename << std::endl;
+        exit(EXIT_FAILURE);
     }
-    return digits;
 }
 
-// Linking the function with C
-extern "C" struct Result run_simulation(
+/* Restores the state of the given cache module from a snapshot of the same cache geometry.
+ * Exits the program if the file is missing, broken or doesn't fit the cache. */
+template<typename Cache>
+void loadSnapshot(const char* filename, Cache& cache, int directMapped, unsigned cacheLines, unsigned cacheLineSize) {
+    std::ifstream in(filename, std::ios::binary);
+    if(!in) {
+        std::cerr << "Error opening state snapshot " << filename << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    char magic[sizeof(snapshotMagic)];
+    uint32_t version, lines, lineSize;
+    uint8_t type, addressBits;
+    if(!in.read(magic, sizeof(magic)) || !std::equal(magic, magic + sizeof(magic), snapshotMagic)
+       || !readSnapshotValue(in, version) || version != snapshotVersion) {
+        std::cerr << "Not a valid state snapshot: " << filename << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    if(!readSnapshotValue(in, type) || !readSnapshotValue(in, lines) || !readSnapshotValue(in, lineSize)
+       || !readSnapshotValue(in, addressBits) || type != (directMapped ? 1 : 0) || lines != cacheLines
+       || lineSize != cacheLineSize || addressBits != 8 * sizeof(typename Cache::Tag)) {
+        std::cerr << "State snapshot " << filename << " was taken with a different cache configuration" << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    if(!cache.loadState(in)) {
+        std::cerr << "State snapshot " << filename << " is truncated" << std::endl;
+        exit(EXIT_FAILURE);
+    }
+}
+
+/* Everything after the address translation: the engines without SystemC or the cache modules.
+ * Address is the width of the address signal and of the tags in the models, 32 bits unless
+ * the trace has wider addresses. */
+template<typename Address>
+static Result simulateCache(
     int cycles,
     int directMapped,
-    unsigned cacheLines,  
+    unsigned cacheLines,
     unsigned cacheLineSize,
     unsigned cacheLatency,
     unsigned memoryLatency,
     size_t numRequests,
     struct Request* requests,
-    const char* tracefile) 
+    const char* tracefile,
+    const struct SimulationOptions* options,
+    unsigned addressBits)
     {
-        // split in offset and index bits
+        // split in offset bits and the set, which is the line address modulo the number of sets
         unsigned offsetBitsCount = log2(cacheLineSize);
         unsigned offsetBitsMask = (1 << offsetBitsCount) - 1;
-        unsigned indexBitsCount = log2(cacheLines);
-        unsigned indexBitsMask = (cacheLines - 1) << offsetBitsCount;
         unsigned numberOfSets =  cacheLines / 4;
-        unsigned setIndexBitsCount = log2(numberOfSets);
-        unsigned setIndexMask = (numberOfSets - 1) << offsetBitsCount;
+
+        size_t primitiveGateCount = calculatePrimitiveGateCount(directMapped, cacheLines, cacheLineSize, addressBits);
+        size_t indexHashGateCount = calculateIndexHashGateCount(options->indexFunction, directMapped, cacheLines, cacheLineSize,
+                                                                addressBits);
+        primitiveGateCount += indexHashGateCount;
+        unsigned sectorSize = options->sectorSize > 0 ? options->sectorSize : cacheLineSize;
+        primitiveGateCount += calculateSectorGateCount(cacheLines, cacheLineSize, sectorSize);
+
+        // Split L1: fetches go to an instruction cache of their own geometry
+        const CacheConfig* instructionCache = options->tlm ? options->instructionCache : NULL;
+        if(instructionCache != NULL) {
+            primitiveGateCount += calculatePrimitiveGateCount(instructionCache->directMapped, instructionCache->cacheLines,
+                                                              instructionCache->cacheLineSize, addressBits);
+        }
+        if(options->lowerLevel != NULL) {
+            primitiveGateCount += calculatePrimitiveGateCount(options->lowerLevel->directMapped, options->lowerLevel->cacheLines,
+                                                              options->lowerLevel->cacheLineSize, addressBits);
+        }
+
+        // The first requests only warm up the cache and aren't part of the timed simulation
+        size_t warmupCount = std::min<size_t>(options->warmupRequests, numRequests);
+        Request* timedRequests = requests + warmupCount;
+        size_t numTimedRequests = numRequests - warmupCount;
+
+        // Set-partitioned simulation on several threads, gives the same hits, misses and cycles without SystemC
+        if(options->threads > 1) {
+            auto run = runParallelSimulation<BasicFunctionalCache<Address>>;
+            Result result = run(cycles, directMapped, offsetBitsCount, directMapped ? cacheLines : numberOfSets,
+                                cacheLatency, memoryLatency, numRequests, requests, warmupCount, options->threads);
+            result.primitiveGateCount = primitiveGateCount;
+            return result;
+        }
+
+        // Time-parallel simulation of contiguous chunks, stitched with an estimated error
+        if(options->chunks > 1) {
+            auto run = runChunkedSimulation<BasicFunctionalCache<Address>>;
+            Result result = run(cycles, directMapped, offsetBitsCount, directMapped ? cacheLines : numberOfSets,
+                                cacheLatency, memoryLatency, numRequests, requests, warmupCount,
+                                options->chunks, options->chunkWarmup);
+            result.primitiveGateCount = primitiveGateCount;
+            return result;
+        }
+
+        // Set sampling: only requests whose first byte maps to a sampled set reach the cache
+        unsigned sampleRate = options->sampleRate > 1 ? options->sampleRate : 1;
+        unsigned simulatedSets = directMapped ? cacheLines : numberOfSets;
+        IndexHash simulatedSetIndex(INDEX_BITSLICE, offsetBitsCount, simulatedSets);
+        std::vector<uint32_t> sampledSets;
+        std::vector<Request> sampledRequests;
+        std::vector<size_t> sampledPositions; // position of each sampled request in the original trace
+
+        if(sampleRate > 1) {
+            for(uint32_t set = 0; set < simulatedSets; ++set) {
+                if(isSampledSet(set, sampleRate)) {
+                    sampledSets.push_back(set);
+                }
+            }
+            for(size_t i = 0; i < numTimedRequests; ++i) {
+                if(isSampledSet(simulatedSetIndex.index(timedRequests[i].addr), sampleRate)) {
+                    sampledRequests.push_back(timedRequests[i]);
+                    sampledPositions.push_back(i);
+                }
+            }
+        }
+
+        size_t simulatedRequestsCount = sampleRate > 1 ? sampledRequests.size() : numTimedRequests;
+        Request* simulatedRequests = sampleRate > 1 ? sampledRequests.data() : timedRequests;
+
+        // The sampled sets only see a part of the cycles, the limit is applied to the extrapolated cycles instead
+        size_t simulatedCycles = sampleRate > 1 ? SIZE_MAX : (size_t)cycles;
 
         // result signals
         sc_signal<size_t> cycleCountSignal;
         sc_signal<size_t, SC_MANY_WRITERS> missCountSignal;
         sc_signal<size_t, SC_MANY_WRITERS> hitCountSignal;
-        size_t primitiveGateCount = 0;
 
         //communication signals
         sc_signal<int> weSignal;
+        sc_signal<unsigned> sizeSignal;
+        sc_signal<unsigned> streamSignal;
         sc_signal<sc_uint<32>, SC_MANY_WRITERS> dataSignal;
-        sc_signal<sc_uint<32>> addrSignal;
+        sc_signal<sc_uint<8 * sizeof(Address)>> addrSignal;
         sc_signal<bool, SC_MANY_WRITERS> readySignal;
         readySignal.write(true);
 
-        // clock
-        sc_clock clk("clk", 1,SC_NS);
-
         sc_trace_file* traceFile;
 
         // If wanted then create tracefile with all signals
@@ -69,94 +201,575 @@ extern "C" struct Result run_simulation(
             sc_trace(traceFile, addrSignal, " addr ");
             sc_trace(traceFile, dataSignal, " data ");
             sc_trace(traceFile, weSignal, " we ");
+            sc_trace(traceFile, sizeSignal, " size ");
+            sc_trace(traceFile, streamSignal, " stream ");
             sc_trace(traceFile, readySignal, " cache ready ");
         }
 
-        // Creating and port binding of cpu
-        CPU cpu("cpu", numRequests, requests, cycles);
-        cpu.clk(clk);
-        cpu.cycles.bind(cycleCountSignal);
-        cpu.we(weSignal);
-        cpu.data(dataSignal);
-        cpu.addr(addrSignal);
-        cpu.cache_ready(readySignal);
+        // The modules have to outlive sc_start() so that their statistics can be read afterwards
+        std::unique_ptr<sc_clock> clk;
+        std::unique_ptr<CPU<Address>> cpu;
+        std::unique_ptr<DIRECT_MAPPED_CACHE<Address>> direct_mapped_cache;
+        std::unique_ptr<FOURWAY_CACHE<Address>> fourwaycache;
+        std::unique_ptr<TLM_CPU> tlmCpu;
+        std::unique_ptr<TLM_CACHE<BasicDirectMappedModel<Address>>> tlmDirectMappedCache;
+        std::unique_ptr<TLM_CACHE<BasicFourWayModel<Address>>> tlmFourWayCache;
+        std::unique_ptr<TLM_CACHE<BasicDirectMappedModel<Address>>> tlmInstructionDirectMappedCache;
+        std::unique_ptr<TLM_CACHE<BasicFourWayModel<Address>>> tlmInstructionFourWayCache;
+
+        // State of the chosen cache, no matter which module holds it
+        BasicDirectMappedModel<Address>* directMappedModel = NULL;
+        BasicFourWayModel<Address>* fourWayModel = NULL;
+        // State of the instruction cache, both NULL with a unified L1
+        BasicDirectMappedModel<Address>* instructionDirectMappedModel = NULL;
+        BasicFourWayModel<Address>* instructionFourWayModel = NULL;
+        // Memory timing of every cache module, they all share the DRAM, bus and lower level
+        std::vector<MainMemoryTiming*> memoryTimings;
 
+        // Row buffer timing of main memory, shared by whichever cache module is used
+        std::unique_ptr<DramModel> dram;
+        if(options->dram != NULL) {
+            dram.reset(new DramModel(*options->dram, cacheLineSize));
+        }
+
+        // Bandwidth limited bus between cache and main memory
+        std::unique_ptr<MemoryBusModel> bus;
+        if(options->busBytesPerCycle > 0) {
+            bus.reset(new MemoryBusModel(options->busBytesPerCycle));
+        }
 
-        // Choosing which cache to use
+        // Unified cache between the L1 caches and main memory
+        std::unique_ptr<LowerLevelCache> lowerLevel;
+        if(options->lowerLevel != NULL) {
+            lowerLevel.reset(new LowerLevelCache(options->lowerLevel->directMapped, options->lowerLevel->cacheLines,
+                                                 options->lowerLevel->cacheLineSize, options->lowerLevelLatency));
+        }
+
+        if(options->tlm) {
+            // Loosely-timed transactions, the CPU may run ahead by one quantum
+            tlm::tlm_global_quantum::instance().set(sc_time(options->quantum, SC_NS));
+            tlmCpu.reset(new TLM_CPU("cpu", simulatedRequestsCount, simulatedRequests, simulatedCycles, instructionCache != NULL));
+
+            if(directMapped) {
+                tlmDirectMappedCache.reset(new TLM_CACHE<BasicDirectMappedModel<Address>>("direct_cache", cacheLatency, memoryLatency, cacheLineSize,
+                                                                                           offsetBitsCount, offsetBitsMask, cacheLines));
+                tlmCpu->socket.bind(tlmDirectMappedCache->socket);
+                directMappedModel = &tlmDirectMappedCache->model;
+                memoryTimings.push_back(&tlmDirectMappedCache->memoryTiming);
+                tlmDirectMappedCache->memoryTiming.fetchSize = sectorSize;
+            } else {
+                tlmFourWayCache.reset(new TLM_CACHE<BasicFourWayModel<Address>>("fourwaycache", cacheLatency, memoryLatency, cacheLineSize,
+                                                                                 offsetBitsCount, offsetBitsMask, numberOfSets));
+                tlmCpu->socket.bind(tlmFourWayCache->socket);
+                fourWayModel = &tlmFourWayCache->model;
+                memoryTimings.push_back(&tlmFourWayCache->memoryTiming);
+                tlmFourWayCache->memoryTiming.fetchSize = sectorSize;
+            }
+
+            if(instructionCache != NULL) {
+                // The instruction cache has whole lines and the bit slice index of its own geometry
+                unsigned lineSize = instructionCache->cacheLineSize;
+                unsigned offsetBits = log2(lineSize);
+                unsigned lines = instructionCache->cacheLines;
+
+                if(instructionCache->directMapped) {
+                    tlmInstructionDirectMappedCache.reset(new TLM_CACHE<BasicDirectMappedModel<Address>>("instruction_direct_cache", cacheLatency, memoryLatency, lineSize,
+                                                                                                          offsetBits, lineSize - 1, lines));
+                    tlmCpu->fetchSocket->bind(tlmInstructionDirectMappedCache->socket);
+                    instructionDirectMappedModel = &tlmInstructionDirectMappedCache->model;
+                    memoryTimings.push_back(&tlmInstructionDirectMappedCache->memoryTiming);
+                } else {
+                    tlmInstructionFourWayCache.reset(new TLM_CACHE<BasicFourWayModel<Address>>("instruction_fourwaycache", cacheLatency, memoryLatency, lineSize,
+                                                                                                offsetBits, lineSize - 1, lines / 4));
+                    tlmCpu->fetchSocket->bind(tlmInstructionFourWayCache->socket);
+                    instructionFourWayModel = &tlmInstructionFourWayCache->model;
+                    memoryTimings.push_back(&tlmInstructionFourWayCache->memoryTiming);
+                }
+            }
+        } else {
+            // clock
+            clk.reset(new sc_clock("clk", 1,SC_NS));
+
+            // Creating and port binding of cpu
+            cpu.reset(new CPU<Address>("cpu", simulatedRequestsCount, simulatedRequests, simulatedCycles));
+            cpu->clk(*clk);
+            cpu->cycles.bind(cycleCountSignal);
+            cpu->we(weSignal);
+            cpu->size(sizeSignal);
+            cpu->stream(streamSignal);
+            cpu->data(dataSignal);
+            cpu->addr(addrSignal);
+            cpu->cache_ready(readySignal);
+
+            // Choosing which cache to use
+            if(directMapped) {
+                // defining the components for this case
+                direct_mapped_cache.reset(new DIRECT_MAPPED_CACHE<Address>("direct_cache", cacheLineSize, cacheLatency, memoryLatency, offsetBitsCount, offsetBitsMask, cacheLines));
+                
+                // functional bindings
+                direct_mapped_cache->cache_ready(readySignal); // inout
+                direct_mapped_cache->addrFromCPU(addrSignal);
+                direct_mapped_cache->dataFromCPU(dataSignal); // inout
+                direct_mapped_cache->weFromCPU(weSignal);
+                direct_mapped_cache->sizeFromCPU(sizeSignal);
+                direct_mapped_cache->streamFromCPU(streamSignal);
+
+                // result related bindings
+                direct_mapped_cache->missesResult.bind(missCountSignal);
+                direct_mapped_cache->hitsResult.bind(hitCountSignal);
+
+                directMappedModel = &direct_mapped_cache->model;
+                memoryTimings.push_back(&direct_mapped_cache->memoryTiming);
+                direct_mapped_cache->memoryTiming.fetchSize = sectorSize;
+            } else {
+                // defining the components for this case
+                fourwaycache.reset(new FOURWAY_CACHE<Address>("fourwaycache", cacheLineSize, cacheLatency, memoryLatency,
+                                                              offsetBitsCount, offsetBitsMask, numberOfSets));
+                
+                // functional bindings
+                fourwaycache->ready(readySignal); // inout
+                fourwaycache->addr(addrSignal);
+                fourwaycache->data(dataSignal); // inout
+                fourwaycache->we(weSignal);
+                fourwaycache->size(sizeSignal);
+                fourwaycache->stream(streamSignal);
+
+                // result related bindings
+                fourwaycache->missCount.bind(missCountSignal);
+                fourwaycache->hitCount.bind(hitCountSignal);
+
+                fourWayModel = &fourwaycache->model;
+                memoryTimings.push_back(&fourwaycache->memoryTiming);
+                fourwaycache->memoryTiming.fetchSize = sectorSize;
+            }
+        }
+
+        for(MainMemoryTiming* memoryTiming : memoryTimings) {
+            memoryTiming->dram = dram.get();
+            memoryTiming->bus = bus.get();
+            memoryTiming->lowerLevel = lowerLevel.get();
+        }
+
+        // Timing only, skips line data, main memory and the read data writeback
+        if(options->noData) {
+            if(directMapped) {
+                directMappedModel->trackData = false;
+            } else {
+                fourWayModel->trackData = false;
+            }
+            if(instructionDirectMappedModel != NULL) {
+                instructionDirectMappedModel->trackData = false;
+            }
+            if(instructionFourWayModel != NULL) {
+                instructionFourWayModel->trackData = false;
+            }
+            if(options->tlm) {
+                tlmCpu->writeBack = false;
+            } else {
+                cpu->writeBack = false;
+            }
+        }
+
+        // Index function of the cache, the models start with the bit slice
         if(directMapped) {
-            // defining the components for this case
-            DIRECT_MAPPED_CACHE direct_mapped_cache("direct_cache", cacheLineSize, cacheLatency, memoryLatency, offsetBitsCount, offsetBitsMask, indexBitsCount, indexBitsMask);
-            
-            // functional bindings
-            direct_mapped_cache.cache_ready(readySignal); // inout
-            direct_mapped_cache.addrFromCPU(addrSignal);
-            direct_mapped_cache.dataFromCPU(dataSignal); // inout
-            direct_mapped_cache.weFromCPU(weSignal);
-
-            // result related bindings
-            direct_mapped_cache.missesResult.bind(missCountSignal);
-            direct_mapped_cache.hitsResult.bind(hitCountSignal);
-
-            // primitive gate count calculation based on the inputs for cacheLines and cacheLineSize
-            // 2 Multiplexers
-            primitiveGateCount += log2(cacheLines) * 4 * 2;
-            // 1 Comparator
-            primitiveGateCount += (32 - indexBitsCount - offsetBitsCount) * 2;
-            // for each bit in cache 1 SRAM (2 gates) for data and tag
-            primitiveGateCount += (cacheLines * 2 * (cacheLineSize * 8 + 32 - indexBitsCount - offsetBitsCount));
+            directMappedModel->indexHash = IndexHash(options->indexFunction, offsetBitsCount, cacheLines);
+        } else {
+            fourWayModel->indexHash = IndexHash(options->indexFunction, offsetBitsCount, numberOfSets);
+        }
 
+        // Way partitioning between the streams
+        if(fourWayModel != NULL) {
+            fourWayModel->wayMasks = options->wayMasks;
+        }
+        if(instructionFourWayModel != NULL) {
+            instructionFourWayModel->wayMasks = options->wayMasks;
+        }
 
+        // Sectored lines only fetch the missing sector
+        if(directMapped) {
+            directMappedModel->sectorSize = sectorSize;
         } else {
-            // defining the components for this case
-            FOURWAY_CACHE fourwaycache("fourwaycache", cacheLineSize, cacheLatency, memoryLatency,
-                                       offsetBitsCount, offsetBitsMask, setIndexBitsCount, setIndexMask);
-            
-            // functional bindings
-            fourwaycache.ready(readySignal); // inout
-            fourwaycache.addr(addrSignal);
-            fourwaycache.data(dataSignal); // inout
-            fourwaycache.we(weSignal);
+            fourWayModel->sectorSize = sectorSize;
+        }
 
-            // result related bindings
-            fourwaycache.missCount.bind(missCountSignal);
-            fourwaycache.hitCount.bind(hitCountSignal);
+        // Warm start from a previous run
+        if(options->loadStateFile != NULL) {
+            if(directMapped) {
+                loadSnapshot(options->loadStateFile, *directMappedModel, directMapped, cacheLines, cacheLineSize);
+            } else {
+                loadSnapshot(options->loadStateFile, *fourWayModel, directMapped, cacheLines, cacheLineSize);
+            }
+        }
 
-            // primitive gate count calculation based on the inputs for cacheLines and cacheLineSize
-            //2 numberOfSets-to-1 multiplexers
-            primitiveGateCount += log2(numberOfSets) * 4 * 2;
-            //4 32-bits comparator
-            primitiveGateCount += (2 * (32 - setIndexBitsCount - offsetBitsCount)) * 4;
-            //4 32-bits 3-state-buffers
-            primitiveGateCount += 32 * 3 * 4;
-            //for each bit in cache 1 SRAM (2 gates) for data and tag
-            primitiveGateCount += (cacheLines * 2 * (cacheLineSize * 8 + 32 - setIndexBitsCount - offsetBitsCount));
-            //replace algorithm
-            primitiveGateCount += numberOfSets * 110;
+        // Functional warm-up without timing, the counters of the caches stay untouched
+        for(size_t i = 0; i < warmupCount; ++i) {
+            if(!isSampledSet(simulatedSetIndex.index(requests[i].addr), sampleRate)) {
+                continue;
+            }
+            // The lines the L1 cache fetched warm up the lower level as well, the data cache's timing comes first
+            if(requests[i].fetch && instructionDirectMappedModel != NULL) {
+                instructionDirectMappedModel->warmUp(requests[i]);
+                memoryTimings[1]->warmUp(instructionDirectMappedModel->fetchedLineAddresses);
+            } else if(requests[i].fetch && instructionFourWayModel != NULL) {
+                instructionFourWayModel->warmUp(requests[i]);
+                memoryTimings[1]->warmUp(instructionFourWayModel->fetchedLineAddresses);
+            } else if(directMapped) {
+                directMappedModel->warmUp(requests[i]);
+                memoryTimings[0]->warmUp(directMappedModel->fetchedLineAddresses);
+            } else {
+                fourWayModel->warmUp(requests[i]);
+                memoryTimings[0]->warmUp(fourWayModel->fetchedLineAddresses);
+            }
+        }
 
+        // Time series of the cache counters, every interval is written as soon as it ends
+        std::unique_ptr<IntervalStatistics> intervals;
+        if(options->interval > 0) {
+            intervals.reset(new IntervalStatistics(options->intervalFile, options->intervalJson, options->interval,
+                                                   options->intervalInCycles, cacheLines));
+            if(!intervals->out) {
+                std::cerr << "Error opening interval file " << options->intervalFile << std::endl;
+                exit(EXIT_FAILURE);
+            }
+            if(directMapped) {
+                intervals->begin(*directMappedModel);
+            } else {
+                intervals->begin(*fourWayModel);
+            }
 
+            if(direct_mapped_cache) {
+                direct_mapped_cache->intervals = intervals.get();
+            } else if(fourwaycache) {
+                fourwaycache->intervals = intervals.get();
+            } else if(tlmDirectMappedCache) {
+                tlmDirectMappedCache->intervals = intervals.get();
+            } else {
+                tlmFourWayCache->intervals = intervals.get();
+            }
         }
 
-        sc_start();
+        // Nothing to simulate if no request falls into a sampled set
+        if(simulatedRequestsCount > 0) {
+            sc_start();
+        }
 
         // It is used for suppressing a message from systemC about stopping simulation
         std::cout.clear();
 
+        // The last interval ends with the simulation
+        if(intervals) {
+            size_t end = (size_t)(sc_time_stamp() / sc_time(1, SC_NS));
+            if(!(directMapped ? intervals->finish(*directMappedModel, end) : intervals->finish(*fourWayModel, end))) {
+                std::cerr << "Error writing interval file " << options->intervalFile << std::endl;
+                exit(EXIT_FAILURE);
+            }
+        }
+
+        if(options->saveStateFile != NULL) {
+            if(directMapped) {
+                saveSnapshot(options->saveStateFile, *directMappedModel, directMapped, cacheLines, cacheLineSize);
+            } else {
+                saveSnapshot(options->saveStateFile, *fourWayModel, directMapped, cacheLines, cacheLineSize);
+            }
+        }
+
         // Closing the tracefile if before opened
         if(tracefile != NULL) {
             sc_close_vcd_trace_file ( traceFile ) ;
         }
 
         // Creating result struct
+        // The TLM modules don't drive the result signals
         Result result = {
-                .cycles = cycleCountSignal.read(),
-                .misses = missCountSignal.read(),
-                .hits = hitCountSignal.read(),
-                .primitiveGateCount = primitiveGateCount + (100 - (primitiveGateCount % 100)) // just round up
+                .cycles = options->tlm ? tlmCpu->cycles : cycleCountSignal.read(),
+                .misses = options->tlm ? (directMapped ? directMappedModel->misses : fourWayModel->misses) : missCountSignal.read(),
+                .hits = options->tlm ? (directMapped ? directMappedModel->hits : fourWayModel->hits) : hitCountSignal.read(),
+                .primitiveGateCount = primitiveGateCount,
+                .sampledRequests = simulatedRequestsCount,
+                .timedRequests = numTimedRequests,
+                .cyclesMargin = 0,
+                .missesMargin = 0,
+                .hitsMargin = 0,
+                .validatedRequests = 0,
+                .rowHits = 0,
+                .rowMisses = 0,
+                .rowConflicts = 0,
+                .banks = 0,
+                .bankBusyCycles = NULL,
+                .busTransfers = 0,
+                .busBusyCycles = 0,
+                .busQueueingCycles = 0,
+                .sets = simulatedSets,
+                .usedSets = 0,
+                .maxSetAccesses = 0,
+                .setAccessVariation = 0,
+                .indexHashGateCount = indexHashGateCount,
+                .lineMisses = directMapped ? directMappedModel->lineMisses : fourWayModel->lineMisses,
+                .sectorMisses = directMapped ? directMappedModel->sectorMisses : fourWayModel->sectorMisses,
+                .fetchedBytes = 0,
+                .instructionHits = 0,
+                .instructionMisses = 0,
+                .lowerLevelHits = 0,
+                .lowerLevelMisses = 0,
+                .tlbHits = 0,
+                .tlbL2Hits = 0,
+                .tlbWalks = 0,
+                .tlbStallCycles = 0,
+                .walkRequests = 0,
+                .streams = 0,
+                .streamHits = NULL,
+                .streamMisses = NULL,
+                .streamCycles = NULL
         };
+        result.fetchedBytes = (result.lineMisses + result.sectorMisses) * sectorSize;
+
+        // Hits and misses cover both L1 caches, fetched bytes only the data cache
+        if(instructionDirectMappedModel != NULL) {
+            result.instructionHits = instructionDirectMappedModel->hits;
+            result.instructionMisses = instructionDirectMappedModel->misses;
+        } else if(instructionFourWayModel != NULL) {
+            result.instructionHits = instructionFourWayModel->hits;
+            result.instructionMisses = instructionFourWayModel->misses;
+        }
+        result.hits += result.instructionHits;
+        result.misses += result.instructionMisses;
+
+        // Statistics of every stream over both L1 caches, only if there is more than the default stream
+        std::vector<SetStatistics> streamStatistics =
+                directMapped ? directMappedModel->streamStatistics : fourWayModel->streamStatistics;
+        const std::vector<SetStatistics>* instructionStreamStatistics =
+                instructionDirectMappedModel != NULL ? &instructionDirectMappedModel->streamStatistics
+                : instructionFourWayModel != NULL ? &instructionFourWayModel->streamStatistics : NULL;
+        if(instructionStreamStatistics != NULL) {
+            for(unsigned stream = 0; stream < MAX_STREAMS; ++stream) {
+                const SetStatistics& instruction = (*instructionStreamStatistics)[stream];
+                streamStatistics[stream].accesses += instruction.accesses;
+                streamStatistics[stream].hits += instruction.hits;
+                streamStatistics[stream].misses += instruction.misses;
+                streamStatistics[stream].cycles += instruction.cycles;
+            }
+        }
+        // Streams up to the highest one that issued a request
+        unsigned streams = MAX_STREAMS;
+        while(streams > 0 && streamStatistics[streams - 1].accesses == 0) {
+            --streams;
+        }
+        if(sampleRate <= 1 && streams > 0 && (options->wayMasks != NULL || streams > 1)) {
+            result.streams = streams;
+            result.streamHits = (size_t*)calloc(result.streams, sizeof(size_t));
+            result.streamMisses = (size_t*)calloc(result.streams, sizeof(size_t));
+            result.streamCycles = (size_t*)calloc(result.streams, sizeof(size_t));
+            for(unsigned stream = 0; stream < streams; ++stream) {
+                result.streamHits[stream] = streamStatistics[stream].hits;
+                result.streamMisses[stream] = streamStatistics[stream].misses;
+                result.streamCycles[stream] = streamStatistics[stream].cycles;
+            }
+        }
+
+        if(lowerLevel) {
+            result.lowerLevelHits = lowerLevel->hits;
+            result.lowerLevelMisses = lowerLevel->misses;
+        }
+
+        // Balance of the requests over all sets, unused sets count with 0 requests
+        const std::vector<SetStatistics>& setStatistics =
+                directMapped ? directMappedModel->setStatistics : fourWayModel->setStatistics;
+        double accessSum = 0, accessSquareSum = 0;
+        for(const SetStatistics& set : setStatistics) {
+            result.usedSets += set.accesses > 0;
+            result.maxSetAccesses = std::max(result.maxSetAccesses, set.accesses);
+            accessSum += set.accesses;
+            accessSquareSum += (double)set.accesses * set.accesses;
+        }
+        if(accessSum > 0) {
+            double mean = accessSum / simulatedSets;
+            result.setAccessVariation = std::sqrt(std::max(accessSquareSum / simulatedSets - mean * mean, 0.0)) / mean;
+        }
+
+        if(dram) {
+            result.rowHits = dram->rowHits;
+            result.rowMisses = dram->rowMisses;
+            result.rowConflicts = dram->rowConflicts;
+            result.banks = dram->banks();
+            result.bankBusyCycles = (size_t*)malloc(sizeof(size_t) * result.banks);
+            std::copy(dram->busyCycles.begin(), dram->busyCycles.end(), result.bankBusyCycles);
+        }
+
+        if(bus) {
+            result.busTransfers = bus->transfers;
+            result.busBusyCycles = bus->busyCycles;
+            result.busQueueingCycles = bus->queueingCycles;
+        }
+
+        if(sampleRate > 1) {
+            // Giving the read data of the simulated requests back to the original trace
+            for(size_t i = 0; i < sampledRequests.size(); ++i) {
+                timedRequests[sampledPositions[i]].data = sampledRequests[i].data;
+            }
+
+            SampledEstimate misses = extrapolate(sampledSets, setStatistics, &SetStatistics::misses, simulatedSets, numTimedRequests);
+            SampledEstimate hits = extrapolate(sampledSets, setStatistics, &SetStatistics::hits, simulatedSets, numTimedRequests);
+            SampledEstimate cyclesEstimate = extrapolate(sampledSets, setStatistics, &SetStatistics::cycles, simulatedSets, numTimedRequests);
+
+            result.misses = (size_t)std::llround(misses.value);
+            result.missesMargin = misses.margin;
+            result.hits = (size_t)std::llround(hits.value);
+            result.hitsMargin = hits.margin;
+
+            // The compute gaps of all requests are known exactly. Like a serial run the simulation
+            // is unfinished if the estimated cycles don't fit into the cycle limit.
+            size_t gapCycles = 0;
+            for(size_t i = 0; i < numTimedRequests; ++i) {
+                gapCycles += timedRequests[i].gap;
+            }
+            result.cycles = (size_t)std::llround(cyclesEstimate.value) + gapCycles;
+            result.cyclesMargin = cyclesEstimate.margin;
+            if(result.cycles > (size_t)cycles) {
+                result.cycles = SIZE_MAX;
+                result.cyclesMargin = 0;
+            }
+        }
         
         return result;
     }
 
+// Linking the function with C
+extern "C" struct Result run_simulation_with_options(
+    int cycles,
+    int directMapped,
+    unsigned cacheLines,  
+    unsigned cacheLineSize,
+    unsigned cacheLatency,
+    unsigned memoryLatency,
+    size_t numRequests,
+    struct Request* requests,
+    const char* tracefile,
+    const struct SimulationOptions* options) 
+    {
+        // The configured address width sizes the hardware, the simulation keeps 32-bit tags unless it is wider
+        unsigned addressBits = options->addressBits > 32 ? options->addressBits : 32;
+        bool wideAddresses = addressBits > 32;
+
+        // Address translation ahead of the cache, the cache is simulated on the translated trace
+        if(options->tlb != NULL) {
+            TlbModel tlb(*options->tlb, wideAddresses);
+            std::vector<size_t> positions;
+            size_t translatedWarmup;
+            std::vector<Request> translated = translateRequests(tlb, requests, numRequests, options->warmupRequests,
+                                                                positions, translatedWarmup);
+
+            SimulationOptions cacheOptions = *options;
+            cacheOptions.tlb = NULL;
+            cacheOptions.warmupRequests = translatedWarmup;
+            Result result = run_simulation_with_options(cycles, directMapped, cacheLines, cacheLineSize, cacheLatency,
+                                                        memoryLatency, translated.size(), translated.data(), tracefile,
+                                                        &cacheOptions);
+
+            // Giving the read data back to the original trace
+            for(size_t i = 0; i < numRequests; ++i) {
+                requests[i].data = translated[positions[i]].data;
+            }
+
+            result.primitiveGateCount += calculateTlbGateCount(options->tlb->l1Entries, options->tlb->l1Ways, options->tlb->pageSize, addressBits)
+                                         + calculateTlbGateCount(options->tlb->l2Entries, options->tlb->l2Ways, options->tlb->pageSize, addressBits);
+            // Requests of the original trace, the sampled ones also count the page table reads
+            result.timedRequests = numRequests - options->warmupRequests;
+            result.tlbHits = tlb.l1Hits;
+            result.tlbL2Hits = tlb.l2Hits;
+            result.tlbWalks = tlb.walks;
+            result.tlbStallCycles = tlb.stallCycles;
+            result.walkRequests = tlb.walkRequests;
+            return result;
+        }
+
+        // The models and the address signal keep 32-bit tags unless the trace has wider addresses
+        return wideAddresses ? simulateCache<uint64_t>(cycles, directMapped, cacheLines, cacheLineSize, cacheLatency, memoryLatency,
+                                                       numRequests, requests, tracefile, options, addressBits)
+                             : simulateCache<uint32_t>(cycles, directMapped, cacheLines, cacheLineSize, cacheLatency, memoryLatency,
+                                                       numRequests, requests, tracefile, options, addressBits);
+    }
+
+// Simulation without any of the optional features
+extern "C" struct Result run_simulation(
+    int cycles,
+    int directMapped,
+    unsigned cacheLines,
+    unsigned cacheLineSize,
+    unsigned cacheLatency,
+    unsigned memoryLatency,
+    size_t numRequests,
+    struct Request* requests,
+    const char* tracefile)
+    {
+        SimulationOptions options = {};
+        return run_simulation_with_options(cycles, directMapped, cacheLines, cacheLineSize, cacheLatency,
+                                           memoryLatency, numRequests, requests, tracefile, &options);
+    }
+
+// One pass over the requests for all configurations with the tag width of Cache
+template<typename Cache>
+static std::vector<Result> simulateConfigs(int cycles, unsigned cacheLatency, unsigned memoryLatency, size_t numRequests,
+                                           const Request* requests, size_t numConfigs, const CacheConfig* configs,
+                                           size_t warmupCount) {
+    std::vector<Cache> caches;
+    for(size_t i = 0; i < numConfigs; ++i) {
+        unsigned sets = configs[i].directMapped ? configs[i].cacheLines : configs[i].cacheLines / 4;
+        caches.emplace_back(configs[i].directMapped, log2(configs[i].cacheLineSize), sets);
+    }
+    return runMultiSimulation(cycles, cacheLatency, memoryLatency, numRequests, requests, warmupCount, caches);
+}
+
+// Simulates all given cache configurations in one pass over the requests, results[i] belongs to configs[i]
+extern "C" void run_multi_simulation(
+    int cycles,
+    unsigned cacheLatency,
+    unsigned memoryLatency,
+    size_t numRequests,
+    struct Request* requests,
+    size_t numConfigs,
+    const struct CacheConfig* configs,
+    struct Result* results,
+    const struct SimulationOptions* options)
+    {
+        unsigned addressBits = options->addressBits > 32 ? options->addressBits : 32;
+        size_t warmupCount = std::min<size_t>(options->warmupRequests, numRequests);
+        auto simulate = addressBits > 32 ? simulateConfigs<WideFunctionalCache> : simulateConfigs<FunctionalCache>;
+        std::vector<Result> simulated = simulate(cycles, cacheLatency, memoryLatency, numRequests, requests,
+                                                 numConfigs, configs, warmupCount);
+
+        for(size_t i = 0; i < numConfigs; ++i) {
+            results[i] = simulated[i];
+            results[i].primitiveGateCount = calculatePrimitiveGateCount(configs[i].directMapped, configs[i].cacheLines,
+                                                                        configs[i].cacheLineSize, addressBits)
+                                            + calculateIndexHashGateCount(INDEX_BITSLICE, configs[i].directMapped,
+                                                                          configs[i].cacheLines, configs[i].cacheLineSize,
+                                                                          addressBits);
+        }
+    }
+
+// Writes the requests the cache sends to the next level as a trace file, returns 1 if it can't be written
+extern "C" int write_filtered_trace(
+    const char* filename,
+    int directMapped,
+    unsigned cacheLines,
+    unsigned cacheLineSize,
+    unsigned cacheLatency,
+    unsigned memoryLatency,
+    size_t numRequests,
+    const struct Request* requests,
+    size_t warmupCount,
+    size_t* filteredRequests,
+    size_t* filteredWarmupRequests)
+    {
+        auto write = requests_address_bits(requests, numRequests) > 32 ? writeFilteredTrace<WideFunctionalCache>
+                                                                         : writeFilteredTrace<FunctionalCache>;
+        TraceFilterResult filtered = write(filename, directMapped, cacheLines, cacheLineSize, cacheLatency,
+                                           memoryLatency, requests, numRequests, warmupCount);
+        *filteredRequests = filtered.requests;
+        *filteredWarmupRequests = filtered.warmupRequests;
+        return filtered.written ? 0 : 1;
+    }
+
 int sc_main(int argc, char* argv[]) {
 
     // Never used so prints error
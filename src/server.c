@@ -0,0 +1,986 @@
+// memfd_create()
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <limits.h>
+#include <ctype.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <time.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+//helper structs
+#include "helper_structs/request.h"
+#include "helper_structs/result.h"
+#include "helper_structs/options.h"
+
+#include "server.h"
+#include "trace.h"
+
+extern struct Result run_simulation_with_options(
+        int cycles,
+        int directMapped,
+        unsigned cacheLines,
+        unsigned cacheLineSize,
+        unsigned cacheLatency,
+        unsigned memoryLatency,
+        size_t numRequests,
+        struct Request* requests,
+        const char* tracefile,
+        const struct SimulationOptions* options);
+
+// Longest accepted job line
+#define MAX_JOB_LENGTH 4096
+
+// Seconds a client may take to send its job line
+#define CLIENT_TIMEOUT 5
+
+// Simulation parameters of one job, sent from the server to a worker
+struct ServerJob {
+    int cycles;
+    int directMapped;
+    unsigned cacheLines;
+    unsigned cacheLineSize;
+    unsigned cacheLatency;
+    unsigned memoryLatency;
+    size_t requestCount;
+    struct SimulationOptions options;
+};
+
+/* Parsed trace kept in a memfd, so workers can map it without parsing or copying.
+ * The file identity detects traces that were changed since they were parsed. */
+struct CachedTrace {
+    char path[PATH_MAX];
+    dev_t device;
+    ino_t inode;
+    struct timespec modified;
+    off_t size;
+    int fd; // -1 if the entry is unused
+    size_t requestCount;
+    unsigned addressBits;
+    int wideStores; // stores wider than 4 bytes, only simulated without data
+    unsigned long lastUse;
+};
+
+/* Trace that isn't cached yet and is parsed by a child process, which sends the memfd back.
+ * The identity of the file is the one the jobs waiting for it saw. */
+struct Parse {
+    pid_t pid;   // 0 if the slot is unused
+    int channel; // socketpair end of the server
+    char path[PATH_MAX];
+    struct stat info;
+};
+
+// Result of a parser, sent together with the memfd of the trace unless error is set
+struct ParsedTrace {
+    size_t requestCount;
+    unsigned addressBits;
+    int wideStores;
+    char error[64];
+};
+
+/* Connection whose job line is still arriving. The server only reads what poll reported,
+ * so a slow client holds up no other job and is dropped after CLIENT_TIMEOUT seconds. */
+struct Connection {
+    int client;
+    long long deadline; // milliseconds of the monotonic clock
+    size_t length;
+    char line[MAX_JOB_LENGTH];
+};
+
+// Job of a connection that waits for its trace to be parsed
+struct PendingJob {
+    int client;
+    struct ServerJob job;
+    struct Parse *parse;
+};
+
+struct Worker {
+    pid_t pid;
+    int channel; // socketpair end of the server
+    int busy;    // got its job and is about to exit
+};
+
+static struct Worker *workers;
+static unsigned workersCount;
+static int listenSocket = -1;
+// connection of the job being dispatched, a child forked meanwhile must not keep it open
+static int currentClient = -1;
+
+/*
+ * JSON job parsing. A job is one flat object of strings, unsigned numbers and booleans.
+ */
+
+static const char *skip_space(const char *p) {
+    while (isspace((unsigned char)*p)) {
+        p++;
+    }
+    return p;
+}
+
+static int parse_json_string(const char **p, char *out, size_t size) {
+    const char *c = *p;
+    size_t length = 0;
+    if (*c++ != '"') {
+        return 1;
+    }
+    while (*c != '"') {
+        if (*c == '\0' || length + 1 >= size) {
+            return 1;
+        }
+        if (*c == '\\') {
+            c++;
+            if (*c != '"' && *c != '\\' && *c != '/') {
+                return 1;
+            }
+        }
+        out[length++] = *c++;
+    }
+    out[length] = '\0';
+    *p = c + 1;
+    return 0;
+}
+
+static int parse_json_unsigned(const char **p, unsigned *value) {
+    char *endptr;
+    if (!isdigit((unsigned char)**p)) {
+        return 1;
+    }
+    errno = 0;
+    unsigned long parsed = strtoul(*p, &endptr, 10);
+    if (errno == ERANGE || parsed > UINT_MAX) {
+        return 1;
+    }
+    *value = (unsigned)parsed;
+    *p = endptr;
+    return 0;
+}
+
+static int parse_json_bool(const char **p, int *value) {
+    if (strncmp(*p, "true", 4) == 0) {
+        *value = 1;
+        *p += 4;
+    } else if (strncmp(*p, "false", 5) == 0) {
+        *value = 0;
+        *p += 5;
+    } else {
+        return 1;
+    }
+    return 0;
+}
+
+/* Parses a job line into job and the trace path with the same defaults as the command line.
+ * Returns 1 and sets error if the line isn't a valid job. */
+static int parse_job(const char *line, struct ServerJob *job, char *trace, size_t traceSize, const char **error) {
+    unsigned cycles = 1000000000;
+    int fourway = 0;
+
+    memset(job, 0, sizeof(*job));
+    job->directMapped = 1;
+    job->cacheLines = 512;
+    job->cacheLineSize = 64;
+    job->cacheLatency = 1;
+    job->memoryLatency = 200;
+    job->options.sampleRate = 1;
+    job->options.threads = 1;
+    job->options.addressBits = 32;
+    trace[0] = '\0';
+
+    const char *p = skip_space(line);
+    if (*p++ != '{') {
+        *error = "job must be a JSON object";
+        return 1;
+    }
+    p = skip_space(p);
+    while (*p != '}') {
+        char key[32];
+        int failed;
+        if (parse_json_string(&p, key, sizeof(key)) != 0) {
+            *error = "invalid key";
+            return 1;
+        }
+        p = skip_space(p);
+        if (*p++ != ':') {
+            *error = "missing ':' after key";
+            return 1;
+        }
+        p = skip_space(p);
+
+        if (strcmp(key, "trace") == 0) {
+            failed = parse_json_string(&p, trace, traceSize);
+        } else if (strcmp(key, "cycles") == 0) {
+            failed = parse_json_unsigned(&p, &cycles) || cycles > INT_MAX;
+        } else if (strcmp(key, "directmapped") == 0) {
+            int directMapped;
+            failed = parse_json_bool(&p, &directMapped);
+            fourway = !directMapped;
+        } else if (strcmp(key, "fourway") == 0) {
+            failed = parse_json_bool(&p, &fourway);
+        } else if (strcmp(key, "cacheline-size") == 0) {
+            failed = parse_json_unsigned(&p, &job->cacheLineSize);
+        } else if (strcmp(key, "cachelines") == 0) {
+            failed = parse_json_unsigned(&p, &job->cacheLines);
+        } else if (strcmp(key, "cache-latency") == 0) {
+            failed = parse_json_unsigned(&p, &job->cacheLatency);
+        } else if (strcmp(key, "memory-latency") == 0) {
+            failed = parse_json_unsigned(&p, &job->memoryLatency);
+        } else if (strcmp(key, "warmup") == 0) {
+            failed = parse_json_unsigned(&p, &job->options.warmupRequests);
+        } else if (strcmp(key, "threads") == 0) {
+            failed = parse_json_unsigned(&p, &job->options.threads);
+        } else if (strcmp(key, "sample-rate") == 0) {
+            failed = parse_json_unsigned(&p, &job->options.sampleRate);
+        } else if (strcmp(key, "address-bits") == 0) {
+            failed = parse_json_unsigned(&p, &job->options.addressBits);
+        } else if (strcmp(key, "no-data") == 0) {
+            failed = parse_json_bool(&p, &job->options.noData);
+        } else {
+            *error = "unknown key";
+            return 1;
+        }
+        if (failed) {
+            *error = "invalid value";
+            return 1;
+        }
+
+        p = skip_space(p);
+        if (*p == ',') {
+            p = skip_space(p + 1);
+        } else if (*p != '}') {
+            *error = "expected ',' or '}'";
+            return 1;
+        }
+    }
+    if (*skip_space(p + 1) != '\0') {
+        *error = "trailing characters after the job";
+        return 1;
+    }
+
+    job->cycles = (int)cycles;
+    job->directMapped = !fourway;
+
+    // Same restrictions as the command line, but without adjusting the cache lines
+    if (trace[0] == '\0') {
+        *error = "trace is required";
+        return 1;
+    }
+    if (job->cacheLineSize == 0 || (job->cacheLineSize & (job->cacheLineSize - 1)) != 0) {
+        *error = "cacheline-size must be a power of 2";
+        return 1;
+    }
+    if (job->cacheLines == 0 || (fourway && job->cacheLines % 4 != 0)) {
+        *error = "cachelines must be at least 1 and a multiple of 4 for a four-way cache";
+        return 1;
+    }
+    if (job->options.threads == 0 || job->options.sampleRate == 0) {
+        *error = "threads and sample-rate can't be 0";
+        return 1;
+    }
+    if (job->options.threads > 1 && job->options.sampleRate > 1) {
+        *error = "threads can't be combined with sample-rate";
+        return 1;
+    }
+    if (job->options.addressBits != 32 && job->options.addressBits != 48 && job->options.addressBits != 64) {
+        *error = "address-bits must be 32, 48 or 64";
+        return 1;
+    }
+    return 0;
+}
+
+// Sends one JSON line to the client, errors of a vanished client are ignored
+static void reply(int client, const char *format, ...) __attribute__((format(printf, 2, 3)));
+static void reply(int client, const char *format, ...) {
+    char buffer[512];
+    va_list arguments;
+    va_start(arguments, format);
+    int length = vsnprintf(buffer, sizeof(buffer), format, arguments);
+    va_end(arguments);
+
+    for (int written = 0, n; written < length; written += n) {
+        if ((n = write(client, buffer + written, length - written)) <= 0) {
+            return;
+        }
+    }
+}
+
+/* Reads what arrived of the job line of a connection. Returns 0 while the line is incomplete,
+ * 1 once it is complete and -1 if it's missing or too long. */
+static int read_job_line(struct Connection *connection) {
+    ssize_t n = read(connection->client, connection->line + connection->length,
+                     sizeof(connection->line) - 1 - connection->length);
+    if (n < 0 && (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK)) {
+        return 0;
+    }
+    if (n > 0) {
+        connection->length += n;
+        connection->line[connection->length] = '\0';
+        char *end = (char *)memchr(connection->line + connection->length - n, '\n', n);
+        if (end != NULL) {
+            *end = '\0';
+            return 1;
+        }
+        return connection->length + 1 < sizeof(connection->line) ? 0 : -1;
+    }
+    // The client closed its side, a line without newline is complete as well
+    connection->line[connection->length] = '\0';
+    return connection->length > 0 ? 1 : -1;
+}
+
+// Grows array to hold at least count elements of size bytes, returns 1 if there's no space
+static int reserve(void **array, size_t *capacity, size_t count, size_t size) {
+    if (count <= *capacity) {
+        return 0;
+    }
+    size_t grown = *capacity > 0 ? 2 * *capacity : 16;
+    while (grown < count) {
+        grown *= 2;
+    }
+    void *resized = realloc(*array, grown * size);
+    if (resized == NULL) {
+        return 1;
+    }
+    *array = resized;
+    *capacity = grown;
+    return 0;
+}
+
+static long long monotonic_ms(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000LL + now.tv_nsec / 1000000;
+}
+
+static struct CachedTrace *cachedTraces;
+static unsigned cachedTracesCount;
+static unsigned long useCounter;
+
+static struct Parse *parses;
+static unsigned parsesCount;
+
+static struct PendingJob *pendingJobs;
+static size_t pendingJobsCount, pendingJobsCapacity;
+
+static struct Connection *connections;
+static size_t connectionsCount, connectionsCapacity;
+
+/*
+ * Child processes. SystemC can only elaborate and run one simulation per process,
+ * so every worker runs exactly one job and is replaced by a freshly forked one.
+ * Traces that aren't cached are parsed by a child of their own, so the server keeps
+ * accepting and dispatching jobs of cached traces meanwhile.
+ */
+
+// Sends size bytes of data together with count file descriptors (at most 2)
+static int send_message(int channel, const void *data, size_t size, const int *fds, unsigned count) {
+    char control[CMSG_SPACE(2 * sizeof(int))];
+    struct iovec iov = {.iov_base = (void *)data, .iov_len = size};
+    struct msghdr message = {.msg_iov = &iov, .msg_iovlen = 1};
+
+    if (count > 0) {
+        message.msg_control = control;
+        message.msg_controllen = CMSG_SPACE(count * sizeof(int));
+        struct cmsghdr *header = CMSG_FIRSTHDR(&message);
+        header->cmsg_level = SOL_SOCKET;
+        header->cmsg_type = SCM_RIGHTS;
+        header->cmsg_len = CMSG_LEN(count * sizeof(int));
+        memcpy(CMSG_DATA(header), fds, count * sizeof(int));
+    }
+    return sendmsg(channel, &message, 0) == (ssize_t)size ? 0 : 1;
+}
+
+/* Receives a message of size bytes with up to count file descriptors (at most 2).
+ * Returns the number of received descriptors or -1 if the message is missing or malformed. */
+static int receive_message(int channel, void *data, size_t size, int *fds, unsigned count) {
+    char control[CMSG_SPACE(2 * sizeof(int))];
+    struct iovec iov = {.iov_base = data, .iov_len = size};
+    struct msghdr message = {.msg_iov = &iov, .msg_iovlen = 1, .msg_control = control,
+                             .msg_controllen = CMSG_SPACE(count * sizeof(int))};
+
+    ssize_t n;
+    while ((n = recvmsg(channel, &message, 0)) < 0 && errno == EINTR) {
+    }
+    if (n < 0) {
+        return -1;
+    }
+    struct cmsghdr *header = CMSG_FIRSTHDR(&message);
+    if (header == NULL) {
+        return n == (ssize_t)size ? 0 : -1;
+    }
+    if (header->cmsg_type != SCM_RIGHTS || header->cmsg_len != CMSG_LEN(count * sizeof(int))) {
+        return -1;
+    }
+    memcpy(fds, CMSG_DATA(header), count * sizeof(int));
+    if (n != (ssize_t)size) {
+        for (unsigned i = 0; i < count; i++) {
+            close(fds[i]);
+        }
+        return -1;
+    }
+    return (int)count;
+}
+
+// Sends the job together with the client connection and the trace memfd to a worker
+static int send_job(int channel, const struct ServerJob *job, int client, int traceFd) {
+    int fds[2] = {client, traceFd};
+    return send_message(channel, job, sizeof(*job), fds, 2);
+}
+
+static int receive_job(int channel, struct ServerJob *job, int *client, int *traceFd) {
+    int fds[2];
+    if (receive_message(channel, job, sizeof(*job), fds, 2) != 2) {
+        return 1;
+    }
+    *client = fds[0];
+    *traceFd = fds[1];
+    return 0;
+}
+
+// A forked child only keeps its own channel, everything else belongs to the server
+static void close_server_fds(void) {
+    close(listenSocket);
+    if (currentClient >= 0) {
+        close(currentClient);
+    }
+    for (unsigned i = 0; i < workersCount; i++) {
+        if (workers[i].pid > 0) {
+            close(workers[i].channel);
+        }
+    }
+    for (unsigned i = 0; i < cachedTracesCount; i++) {
+        if (cachedTraces[i].fd >= 0) {
+            close(cachedTraces[i].fd);
+        }
+    }
+    for (unsigned i = 0; i < parsesCount; i++) {
+        if (parses[i].pid > 0) {
+            close(parses[i].channel);
+        }
+    }
+    for (size_t i = 0; i < pendingJobsCount; i++) {
+        close(pendingJobs[i].client);
+    }
+    for (size_t i = 0; i < connectionsCount; i++) {
+        close(connections[i].client);
+    }
+}
+
+// Creates a channel and forks, returns the pid (0 in the child) or -1 with a message on stderr
+static pid_t fork_child(int channel[2], const char *what) {
+    if (socketpair(AF_UNIX, SOCK_SEQPACKET, 0, channel) != 0) {
+        fprintf(stderr, "Error creating %s channel: %s\n", what, strerror(errno));
+        return -1;
+    }
+
+    // Nothing buffered may be written twice
+    fflush(stdout);
+    fflush(stderr);
+
+    pid_t pid = fork();
+    if (pid < 0) {
+        fprintf(stderr, "Error forking %s: %s\n", what, strerror(errno));
+        close(channel[0]);
+        close(channel[1]);
+        return -1;
+    }
+    if (pid == 0) {
+        close_server_fds();
+        close(channel[0]);
+    } else {
+        close(channel[1]);
+    }
+    return pid;
+}
+
+static void run_worker(int channel) {
+    struct ServerJob job;
+    int client, traceFd;
+
+    // Server closed the channel -> shutting down
+    if (receive_job(channel, &job, &client, &traceFd) != 0) {
+        exit(EXIT_SUCCESS);
+    }
+
+    // Private mapping: read data written back by the simulation must not change the cached trace
+    size_t bytes = sizeof(struct Request) * job.requestCount;
+    struct Request *requests = (struct Request *)mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE, traceFd, 0);
+    if (requests == MAP_FAILED) {
+        reply(client, "{\"error\": \"can't map trace: %s\"}\n", strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+
+    struct Result result = run_simulation_with_options(job.cycles, job.directMapped, job.cacheLines, job.cacheLineSize,
+                                                       job.cacheLatency, job.memoryLatency, job.requestCount, requests,
+                                                       NULL, &job.options);
+
+    reply(client, "{\"finished\": %s, \"cycles\": %zu, \"hits\": %zu, \"misses\": %zu, \"primitiveGateCount\": %zu}\n",
+          result.cycles != SIZE_MAX ? "true" : "false", result.cycles != SIZE_MAX ? result.cycles : 0,
+          result.hits, result.misses, result.primitiveGateCount);
+    exit(EXIT_SUCCESS);
+}
+
+// Forks the worker in slot, returns 1 if it can't be created
+static int spawn_worker(struct Worker *worker) {
+    int channel[2];
+    pid_t pid = fork_child(channel, "worker");
+    if (pid < 0) {
+        return 1;
+    }
+    if (pid == 0) {
+        // The job brings the client and the trace
+        run_worker(channel[1]);
+    }
+
+    worker->pid = pid;
+    worker->channel = channel[0];
+    worker->busy = 0;
+    return 0;
+}
+
+/* Replaces every worker that finished its job. If block is set and no worker is idle,
+ * it waits until one finished. Returns an idle worker or NULL if none could be spawned.
+ * Finished parsers are reaped as well, their result already came over their channel. */
+static struct Worker *idle_worker(int block) {
+    for (;;) {
+        int status;
+        pid_t pid;
+        while ((pid = waitpid(-1, &status, WNOHANG)) > 0) {
+            for (unsigned i = 0; i < workersCount; i++) {
+                if (workers[i].pid == pid) {
+                    close(workers[i].channel);
+                    workers[i].pid = 0;
+                }
+            }
+        }
+
+        struct Worker *idle = NULL;
+        for (unsigned i = 0; i < workersCount; i++) {
+            if (workers[i].pid == 0 && spawn_worker(&workers[i]) != 0) {
+                continue;
+            }
+            if (workers[i].pid > 0 && !workers[i].busy && idle == NULL) {
+                idle = &workers[i];
+            }
+        }
+        if (idle != NULL || !block) {
+            return idle;
+        }
+
+        // Every worker is busy, wait for the first one to finish
+        pid = waitpid(-1, &status, 0);
+        if (pid < 0 && errno == ECHILD) {
+            return NULL;
+        }
+        if (pid > 0) {
+            for (unsigned i = 0; i < workersCount; i++) {
+                if (workers[i].pid == pid) {
+                    close(workers[i].channel);
+                    workers[i].pid = 0;
+                }
+            }
+        }
+    }
+}
+
+/*
+ * Trace cache
+ */
+
+// A trace changed on disk if any of device, inode, size or modification time differ
+static int same_version(const struct CachedTrace *entry, const struct stat *info) {
+    return entry->device == info->st_dev && entry->inode == info->st_ino && entry->size == info->st_size
+           && entry->modified.tv_sec == info->st_mtim.tv_sec && entry->modified.tv_nsec == info->st_mtim.tv_nsec;
+}
+
+static int same_file(const struct stat *a, const struct stat *b) {
+    return a->st_dev == b->st_dev && a->st_ino == b->st_ino && a->st_size == b->st_size
+           && a->st_mtim.tv_sec == b->st_mtim.tv_sec && a->st_mtim.tv_nsec == b->st_mtim.tv_nsec;
+}
+
+// Returns the cached trace of path if it wasn't changed on disk since it was parsed, NULL otherwise
+static struct CachedTrace *find_trace(const char *path, const struct stat *info) {
+    for (unsigned i = 0; i < cachedTracesCount; i++) {
+        struct CachedTrace *entry = &cachedTraces[i];
+        if (entry->fd >= 0 && strcmp(entry->path, path) == 0 && same_version(entry, info)) {
+            entry->lastUse = ++useCounter;
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+// Stores a parsed trace in the entry of its outdated version or instead of the least recently used trace
+static struct CachedTrace *store_trace(const struct Parse *parse, int fd, const struct ParsedTrace *parsed) {
+    struct CachedTrace *leastRecent = &cachedTraces[0];
+    for (unsigned i = 0; i < cachedTracesCount; i++) {
+        struct CachedTrace *entry = &cachedTraces[i];
+        if (entry->fd >= 0 && strcmp(entry->path, parse->path) == 0) {
+            leastRecent = entry;
+            break;
+        }
+        if (entry->fd < 0 || (leastRecent->fd >= 0 && entry->lastUse < leastRecent->lastUse)) {
+            leastRecent = entry;
+        }
+    }
+
+    if (leastRecent->fd >= 0) {
+        close(leastRecent->fd);
+    }
+    strcpy(leastRecent->path, parse->path);
+    leastRecent->device = parse->info.st_dev;
+    leastRecent->inode = parse->info.st_ino;
+    leastRecent->modified = parse->info.st_mtim;
+    leastRecent->size = parse->info.st_size;
+    leastRecent->fd = fd;
+    leastRecent->requestCount = parsed->requestCount;
+    leastRecent->addressBits = parsed->addressBits;
+    leastRecent->wideStores = parsed->wideStores;
+    leastRecent->lastUse = ++useCounter;
+    return leastRecent;
+}
+
+// Copies the requests into a new memfd, returns -1 with a message on stderr if there's no space
+static int write_trace_memory(const struct Request *requests, size_t requestCount) {
+    size_t bytes = sizeof(struct Request) * requestCount;
+    int fd = memfd_create("trace", MFD_CLOEXEC);
+    if (fd < 0 || ftruncate(fd, bytes) != 0) {
+        fprintf(stderr, "Error creating trace memory: %s\n", strerror(errno));
+        if (fd >= 0) {
+            close(fd);
+        }
+        return -1;
+    }
+    for (size_t written = 0; written < bytes;) {
+        ssize_t n = write(fd, (const char *)requests + written, bytes - written);
+        if (n <= 0) {
+            fprintf(stderr, "Error writing trace memory: %s\n", strerror(errno));
+            close(fd);
+            return -1;
+        }
+        written += n;
+    }
+    return fd;
+}
+
+// Parses the trace in a parser process and sends its memfd, or the error without one, to the server
+static void run_parser(int channel, const char *path) {
+    struct ParsedTrace parsed;
+    struct Request *requests;
+    size_t requestCount;
+    int fd = -1;
+
+    memset(&parsed, 0, sizeof(parsed));
+    if (read_trace(path, &requests, &requestCount) != 0) {
+        strcpy(parsed.error, "invalid trace, see server log");
+    } else {
+        if (requestCount == 0) {
+            strcpy(parsed.error, "trace has no requests");
+        } else if ((fd = write_trace_memory(requests, requestCount)) < 0) {
+            strcpy(parsed.error, "no space for trace");
+        }
+        parsed.requestCount = requestCount;
+        parsed.addressBits = requests_address_bits(requests, requestCount);
+        parsed.wideStores = requests_first_wide_store(requests, requestCount) < requestCount;
+        free(requests);
+    }
+
+    send_message(channel, &parsed, sizeof(parsed), &fd, fd >= 0);
+    exit(EXIT_SUCCESS);
+}
+
+/* Returns the running parse of this version of path or forks a parser for it.
+ * Returns NULL and sets error if every parser slot is taken or the fork fails. */
+static struct Parse *start_parse(const char *path, const struct stat *info, const char **error) {
+    struct Parse *unused = NULL;
+    for (unsigned i = 0; i < parsesCount; i++) {
+        struct Parse *parse = &parses[i];
+        if (parse->pid > 0 && strcmp(parse->path, path) == 0 && same_file(&parse->info, info)) {
+            return parse;
+        }
+        if (parse->pid == 0 && unused == NULL) {
+            unused = parse;
+        }
+    }
+    if (unused == NULL) {
+        *error = "too many traces are being parsed, try again later";
+        return NULL;
+    }
+
+    int channel[2];
+    pid_t pid = fork_child(channel, "parser");
+    if (pid < 0) {
+        *error = "can't start parsing the trace";
+        return NULL;
+    }
+    if (pid == 0) {
+        run_parser(channel[1], path);
+    }
+
+    unused->pid = pid;
+    unused->channel = channel[0];
+    strcpy(unused->path, path);
+    unused->info = *info;
+    return unused;
+}
+
+/*
+ * Server
+ */
+
+// Checks the job against its trace and hands both together with the connection to a worker
+static void dispatch_job(int client, struct ServerJob *job, const struct CachedTrace *cached) {
+    if (job->options.warmupRequests >= cached->requestCount) {
+        reply(client, "{\"error\": \"warmup leaves none of the %zu requests to simulate\"}\n", cached->requestCount);
+        return;
+    }
+    if (cached->addressBits > job->options.addressBits) {
+        reply(client, "{\"error\": \"the trace has %u-bit addresses, more than address-bits\"}\n", cached->addressBits);
+        return;
+    }
+    if (cached->wideStores && !job->options.noData) {
+        reply(client, "{\"error\": \"the trace stores more than 4 bytes at once, simulate it with no-data\"}\n");
+        return;
+    }
+    job->requestCount = cached->requestCount;
+
+    struct Worker *worker = idle_worker(1);
+    if (worker == NULL || send_job(worker->channel, job, client, cached->fd) != 0) {
+        reply(client, "{\"error\": \"no worker available\"}\n");
+        return;
+    }
+    worker->busy = 1;
+}
+
+/* Checks the job line of a connection and dispatches it if its trace is cached.
+ * Returns 1 if the job waits for its trace to be parsed, the connection then stays open. */
+static int handle_job(int client, const char *line) {
+    char trace[PATH_MAX];
+    struct ServerJob job;
+    struct stat info;
+    const char *error;
+
+    if (parse_job(line, &job, trace, sizeof(trace), &error) != 0) {
+        reply(client, "{\"error\": \"%s\"}\n", error);
+        return 0;
+    }
+
+    if (stat(trace, &info) != 0) {
+        reply(client, "{\"error\": \"can't open trace\"}\n");
+        return 0;
+    }
+    struct CachedTrace *cached = find_trace(trace, &info);
+    if (cached != NULL) {
+        dispatch_job(client, &job, cached);
+        return 0;
+    }
+    if (!is_csv_file(trace)) {
+        reply(client, "{\"error\": \"trace must be a .csv file\"}\n");
+        return 0;
+    }
+
+    struct Parse *parse = start_parse(trace, &info, &error);
+    if (parse == NULL) {
+        reply(client, "{\"error\": \"%s\"}\n", error);
+        return 0;
+    }
+    if (reserve((void **)&pendingJobs, &pendingJobsCapacity, pendingJobsCount + 1, sizeof(struct PendingJob)) != 0) {
+        reply(client, "{\"error\": \"no space for the job\"}\n");
+        return 0;
+    }
+    pendingJobs[pendingJobsCount++] = (struct PendingJob){.client = client, .job = job, .parse = parse};
+    return 1;
+}
+
+// Takes the result of a parser and dispatches or answers every job that waited for it
+static void finish_parse(struct Parse *parse) {
+    struct ParsedTrace parsed;
+    struct CachedTrace *cached = NULL;
+    const char *error = "can't parse trace, see server log";
+    int fd = -1;
+
+    int fds = receive_message(parse->channel, &parsed, sizeof(parsed), &fd, 1);
+    if (fds == 1 && parsed.error[0] == '\0') {
+        cached = store_trace(parse, fd, &parsed);
+    } else {
+        if (fds == 1) {
+            close(fd);
+        }
+        if (fds == 0 && parsed.error[0] != '\0') {
+            parsed.error[sizeof(parsed.error) - 1] = '\0';
+            error = parsed.error;
+        }
+    }
+    close(parse->channel);
+    parse->pid = 0;
+
+    for (size_t i = 0; i < pendingJobsCount;) {
+        if (pendingJobs[i].parse != parse) {
+            i++;
+            continue;
+        }
+        struct PendingJob pending = pendingJobs[i];
+        pendingJobs[i] = pendingJobs[--pendingJobsCount];
+
+        currentClient = pending.client;
+        if (cached != NULL) {
+            dispatch_job(pending.client, &pending.job, cached);
+        } else {
+            reply(pending.client, "{\"error\": \"%s\"}\n", error);
+        }
+        close(pending.client);
+        currentClient = -1;
+    }
+}
+
+int run_server(const char *socketPath, unsigned workerCount, unsigned cachedTraceCount) {
+    struct sockaddr_un address = {.sun_family = AF_UNIX};
+    if (strlen(socketPath) >= sizeof(address.sun_path)) {
+        fprintf(stderr, "Socket path is too long: %s\n", socketPath);
+        return 1;
+    }
+    strcpy(address.sun_path, socketPath);
+
+    // A client that disconnects early must not kill the server or a worker
+    signal(SIGPIPE, SIG_IGN);
+
+    listenSocket = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listenSocket < 0) {
+        fprintf(stderr, "Error creating socket: %s\n", strerror(errno));
+        return 1;
+    }
+    // Socket file of an earlier server
+    unlink(socketPath);
+    if (bind(listenSocket, (struct sockaddr *)&address, sizeof(address)) != 0 || listen(listenSocket, SOMAXCONN) != 0) {
+        fprintf(stderr, "Error listening on %s: %s\n", socketPath, strerror(errno));
+        close(listenSocket);
+        return 1;
+    }
+
+    // As many traces as workers may be parsed at the same time
+    workers = (struct Worker *)calloc(workerCount, sizeof(struct Worker));
+    cachedTraces = (struct CachedTrace *)calloc(cachedTraceCount, sizeof(struct CachedTrace));
+    parses = (struct Parse *)calloc(workerCount, sizeof(struct Parse));
+    if (workers == NULL || cachedTraces == NULL || parses == NULL) {
+        fprintf(stderr, "No space in memory: %s\n", strerror(errno));
+        free(workers);
+        free(cachedTraces);
+        free(parses);
+        close(listenSocket);
+        return 1;
+    }
+    workersCount = workerCount;
+    cachedTracesCount = cachedTraceCount;
+    parsesCount = workerCount;
+    for (unsigned i = 0; i < cachedTracesCount; i++) {
+        cachedTraces[i].fd = -1;
+    }
+
+    // Prefork all workers before the first job arrives
+    if (idle_worker(0) == NULL) {
+        fprintf(stderr, "Error: no worker could be started\n");
+        return 1;
+    }
+    printf("Listening on %s with %u workers\n", socketPath, workerCount);
+    fflush(stdout);
+
+    struct pollfd *polled = NULL;
+    size_t polledCapacity = 0;
+    for (;;) {
+        // New connections, the channels of the running parsers and the connections whose job line is arriving
+        long long now = monotonic_ms();
+        int timeout = -1;
+        if (reserve((void **)&polled, &polledCapacity, 1 + parsesCount + connectionsCount, sizeof(struct pollfd)) != 0) {
+            fprintf(stderr, "No space in memory: %s\n", strerror(errno));
+            return 1;
+        }
+        nfds_t count = 0;
+        polled[count++] = (struct pollfd){.fd = listenSocket, .events = POLLIN};
+        for (unsigned i = 0; i < parsesCount; i++) {
+            if (parses[i].pid > 0) {
+                polled[count++] = (struct pollfd){.fd = parses[i].channel, .events = POLLIN};
+            }
+        }
+        nfds_t firstConnection = count;
+        for (size_t i = 0; i < connectionsCount; i++) {
+            polled[count++] = (struct pollfd){.fd = connections[i].client, .events = POLLIN};
+            long long remaining = connections[i].deadline > now ? connections[i].deadline - now : 0;
+            if (timeout < 0 || remaining < timeout) {
+                timeout = (int)remaining;
+            }
+        }
+        if (poll(polled, count, timeout) < 0) {
+            if (errno != EINTR) {
+                fprintf(stderr, "Error waiting for connections: %s\n", strerror(errno));
+            }
+            continue;
+        }
+        now = monotonic_ms();
+
+        for (nfds_t i = 1; i < firstConnection; i++) {
+            if (polled[i].revents == 0) {
+                continue;
+            }
+            for (unsigned j = 0; j < parsesCount; j++) {
+                if (parses[j].pid > 0 && parses[j].channel == polled[i].fd) {
+                    finish_parse(&parses[j]);
+                }
+            }
+        }
+
+        // Backwards, so that the last connection moving into a closed one's slot was already handled
+        for (size_t i = count - firstConnection; i-- > 0;) {
+            int status = 0;
+            if (polled[firstConnection + i].revents != 0) {
+                status = read_job_line(&connections[i]);
+            }
+            if (status == 0 && now < connections[i].deadline) {
+                continue;
+            }
+            struct Connection *connection = &connections[i];
+            int client = connection->client;
+            currentClient = client;
+            int waiting = 0;
+            if (status == 1) {
+                waiting = handle_job(client, connection->line);
+            } else if (status == 0) {
+                reply(client, "{\"error\": \"no job line within %d seconds\"}\n", CLIENT_TIMEOUT);
+            } else {
+                reply(client, "{\"error\": \"job must be one line of at most %d bytes\"}\n", MAX_JOB_LENGTH - 1);
+            }
+            if (!waiting) {
+                close(client);
+            }
+            currentClient = -1;
+            connections[i] = connections[--connectionsCount];
+        }
+
+        if (polled[0].revents & POLLIN) {
+            int client = accept(listenSocket, NULL, NULL);
+            if (client < 0) {
+                if (errno != EINTR && errno != ECONNABORTED) {
+                    fprintf(stderr, "Error accepting connection: %s\n", strerror(errno));
+                }
+            } else if (reserve((void **)&connections, &connectionsCapacity, connectionsCount + 1,
+                               sizeof(struct Connection)) != 0) {
+                reply(client, "{\"error\": \"no space for the connection\"}\n");
+                close(client);
+            } else {
+                struct Connection *connection = &connections[connectionsCount++];
+                connection->client = client;
+                connection->deadline = now + CLIENT_TIMEOUT * 1000LL;
+                connection->length = 0;
+            }
+        }
+
+        // Replace finished workers while no job is waiting
+        idle_worker(0);
+    }
+}
@@ -0,0 +1,12 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+/* Runs the simulation daemon on a Unix socket until it is killed. Every connection sends one
+ * JSON job in a single line, e.g. {"trace": "examples/a.csv", "fourway": true, "cachelines": 256},
+ * within 5 seconds and gets one JSON line with the result or an error back. Parsed traces stay in an
+ * LRU cache of cachedTraces entries, a trace that isn't cached is parsed in a child process while
+ * other jobs go on. Every job runs in one of workerCount preforked processes.
+ * Returns 1 with a message on stderr if the socket can't be set up. */
+int run_server(const char *socketPath, unsigned workerCount, unsigned cachedTraces);
+
+#endif
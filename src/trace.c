@@ -0,0 +1,580 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <limits.h>
+#include <ctype.h>
+
+#include "trace.h"
+
+static int convert_hex_to_uint32_t(char *c, uint32_t *u) {
+    char *endptr;
+    errno = 0; // To distinguish success/failure after call
+
+    // Convert string to unsigned long
+    unsigned long value = strtoul(c, &endptr, 16);
+
+    // Check for conversion errors
+    if (endptr == c) {
+        // No digits were found
+        fprintf(stderr, "Invalid number: No digits were found in %s.\n", c);
+        return 1;
+    } else if (*endptr != '\0' && !isspace(*endptr)) {
+        // Further characters after the number
+        fprintf(stderr, "Invalid number: Further characters were found after the number: %s\n", endptr);
+        return 1;
+    } else if ((errno == ERANGE && value == ULONG_MAX) || (value > UINT_MAX)) {
+        // The value is out of range for unsigned int
+        fprintf(stderr, "Invalid number: The number %s is out of range for unsigned int.\n", c);
+        return 1;
+    } else if (errno != 0 && value == 0) {
+        // Other errors
+        fprintf(stderr, "Invalid number: %s\n", c);
+        return 1;
+    }
+
+    // Parsing was successful
+    *u = (uint32_t)value;
+    return 0;
+}
+
+static int convert_dec_to_uint32_t(char *c, uint32_t *u) {
+    char *endptr;
+    errno = 0; // To distinguish success/failure after call
+
+    // Convert string to unsigned long
+    unsigned long value = strtoul(c, &endptr, 10);
+
+    // Check for conversion errors
+    if (endptr == c) {
+        // No digits were found
+        fprintf(stderr, "Invalid number: No digits were found in %s.\n", c);
+        return 1;
+    } else if (*endptr != '\0' && !isspace(*endptr)) {
+        // Further characters after the number
+        fprintf(stderr, "Invalid number: Further characters were found after the number: %c\n", *endptr);
+        return 1;
+    } else if ((errno == ERANGE && value == ULONG_MAX) || (value > UINT_MAX)) {
+        // The value is out of range for unsigned int
+        fprintf(stderr, "Invalid number: The number %s is out of range for unsigned int.\n", c);
+        return 1;
+    } else if (errno != 0 && value == 0) {
+        // Other errors
+        fprintf(stderr, "Invalid number: %s\n", c);
+        return 1;
+    }
+
+    // Parsing was successful
+    *u = (uint32_t)value;
+    return 0;
+}
+
+static int convert_hex_to_uint64_t(char *c, uint64_t *u) {
+    char *endptr;
+    errno = 0; // To distinguish success/failure after call
+
+    // strtoull() would negate a number with a leading '-' instead of rejecting it
+    const char *first = c;
+    while (isspace((unsigned char)*first)) {
+        first++;
+    }
+    if (*first == '-') {
+        fprintf(stderr, "Invalid number: %s is negative.\n", c);
+        return 1;
+    }
+
+    // Convert string to unsigned long long, addresses of 64-bit processes need more than 32 bits
+    unsigned long long value = strtoull(c, &endptr, 16);
+
+    // Check for conversion errors
+    if (endptr == c) {
+        // No digits were found
+        fprintf(stderr, "Invalid number: No digits were found in %s.\n", c);
+        return 1;
+    } else if (*endptr != '\0' && !isspace(*endptr)) {
+        // Further characters after the number
+        fprintf(stderr, "Invalid number: Further characters were found after the number: %s\n", endptr);
+        return 1;
+    } else if (errno == ERANGE && value == ULLONG_MAX) {
+        // The value is out of range for a 64-bit address
+        fprintf(stderr, "Invalid number: The number %s is out of range for a 64-bit address.\n", c);
+        return 1;
+    } else if (errno != 0 && value == 0) {
+        // Other errors
+        fprintf(stderr, "Invalid number: %s\n", c);
+        return 1;
+    }
+
+    // Parsing was successful
+    *u = (uint64_t)value;
+    return 0;
+}
+
+static int convert_dec_to_uint64_t(char *c, uint64_t *u) {
+    char *endptr;
+    errno = 0; // To distinguish success/failure after call
+
+    // strtoull() would negate a number with a leading '-' instead of rejecting it
+    const char *first = c;
+    while (isspace((unsigned char)*first)) {
+        first++;
+    }
+    if (*first == '-') {
+        fprintf(stderr, "Invalid number: %s is negative.\n", c);
+        return 1;
+    }
+
+    // Convert string to unsigned long long
+    unsigned long long value = strtoull(c, &endptr, 10);
+
+    // Check for conversion errors
+    if (endptr == c) {
+        // No digits were found
+        fprintf(stderr, "Invalid number: No digits were found in %s.\n", c);
+        return 1;
+    } else if (*endptr != '\0' && !isspace(*endptr)) {
+        // Further characters after the number
+        fprintf(stderr, "Invalid number: Further characters were found after the number: %c\n", *endptr);
+        return 1;
+    } else if (errno == ERANGE && value == ULLONG_MAX) {
+        // The value is out of range for a 64-bit address
+        fprintf(stderr, "Invalid number: The number %s is out of range for a 64-bit address.\n", c);
+        return 1;
+    } else if (errno != 0 && value == 0) {
+        // Other errors
+        fprintf(stderr, "Invalid number: %s\n", c);
+        return 1;
+    }
+
+    // Parsing was successful
+    *u = (uint64_t)value;
+    return 0;
+}
+
+/* Checks the value of a store wider than 4 bytes: hex with at most two digits per byte or a decimal
+ * number of up to 8 bytes. The value itself is dropped, Request only holds 4 bytes of data. */
+static int check_wide_data(char *c, unsigned size) {
+    while (isspace((unsigned char)*c)) {
+        c++;
+    }
+    if (c[0] == '0' && (c[1] == 'x' || c[1] == 'X')) {
+        char *digits = c + 2;
+        while (*digits == '0') {
+            digits++;
+        }
+        size_t length = strspn(digits, "0123456789abcdefABCDEF");
+        char *end = digits + length;
+        if (end == c + 2) {
+            fprintf(stderr, "Invalid number: No digits were found in %s.\n", c);
+            return 1;
+        }
+        if (*end != '\0' && !isspace((unsigned char)*end)) {
+            fprintf(stderr, "Invalid number: Further characters were found after the number: %s\n", end);
+            return 1;
+        }
+        if (length > 2 * size) {
+            fprintf(stderr, "Invalid number: The number %s doesn't fit into %u bytes.\n", c, size);
+            return 1;
+        }
+        return 0;
+    }
+    uint64_t value;
+    return convert_dec_to_uint64_t(c, &value);
+}
+
+int is_csv_file(const char *filename) {
+    //get the length of the file and it can be maximum NAME_MAX
+    size_t len = strlen(filename);
+    // Check if the last four characters are ".csv"
+    return (len > 4 && strcmp(filename + len - 4, ".csv") == 0);
+}
+
+/* Counts the lines of the file into lines, returns 1 if it can't be opened */
+static int count_lines(const char *filename, size_t *lines) {
+    // count the number of lines in the file called filename implementing statically for now
+
+    FILE *fp = fopen(filename,"r");
+    int ch;
+
+    if (!fp) {
+        fprintf(stderr, "Error opening file %s: %s\n", filename, strerror(errno));
+        return 1;
+    }
+
+    *lines = 1;
+    while ((ch = fgetc(fp)) != EOF) {
+        if (ch == '\n')
+            (*lines)++;
+    }
+
+    fclose(fp);
+    return 0;
+}
+
+static int is_empty_line(char* l) {
+    for (int i = 0; l[i] != '\0'; i++) {
+        if (!isspace(l[i])) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+int read_trace(const char *filename, struct Request **requestsResult, size_t *requestCountResult) {
+    //All lines are counted including blank and invalid lines
+    size_t linesCount;
+    if (count_lines(filename, &linesCount) != 0) {
+        return 1;
+    }
+    size_t emptyLinesCount = 0;
+
+    //Open fp for reading
+    FILE *fp = fopen(filename, "r");
+    if (!fp) {
+        fprintf(stderr, "Error opening fp %s: %s\n", filename, strerror(errno));
+        return 1;
+    }
+    // Request array the number of requests is <= linesCount
+    struct Request* requests = (struct Request*)malloc(sizeof(struct Request) * linesCount);
+    if(requests == NULL) {
+        fprintf(stderr, "No space in memory: %s\n", strerror(errno));
+        fclose(fp);
+        return 1;
+    }
+
+    // Buffer for reading line
+    char line[256];
+
+    // String of parsed value
+    char *column;
+
+    //Request requestCount
+    size_t requestCount = 0;
+
+    // Reading lines one by one
+    while (fgets(line, sizeof(line), fp)) {
+
+        // Everything after '#' is a comment, a line with only a comment counts as empty
+        char *comment = strchr(line, '#');
+        if (comment != NULL) {
+            *comment = '\0';
+        }
+
+        // check if the line empty
+        if(is_empty_line(line)) {
+            emptyLinesCount++;
+            continue;
+        }
+
+        // Temp request members
+        int we;
+        int fetch = 0;
+        uint64_t address;
+        uint32_t data = 0;
+
+        // Boolean for deciding whether the column empty
+        int parsed;
+
+        // First column was empty
+        if(line[0] == ',') {
+            fprintf(stderr, "No operation is given at line %zu\n", requestCount + emptyLinesCount + 1);
+            fclose(fp);
+            free(requests);
+            return 1;
+        }
+
+
+        // Reading first column
+        if ((column = strtok(line, ",")) == NULL) {
+            fprintf(stderr, "Invalid line at %zu found.\n", requestCount + emptyLinesCount + 1);
+            fclose(fp);
+            free(requests);
+            return 1;
+        }
+
+
+        /*
+         * Columns are parsed to strings and the legal values
+         * are 'w', 'r' or 'i' and doesn't matter capital or
+         * not. Before and after letter only white space can be present
+         */
+
+        // Boolean to make sure that just 1 operation is parsed
+        int found = 0;
+
+        // After parsing, it should be 1
+        parsed = 0;
+
+        // Iterating first column
+        for (int i = 0; column[i] != '\0'; i++) {
+            //If white space then skip
+            if (isspace(column[i])) {
+                continue;
+            } else if ((column[i] == 'W' || column[i] == 'w') && !found) {
+                we = 1;
+                //Assign found and parsed variables to true and be sure that after the letter just space comes
+                found = 1;
+                parsed = 1;
+            } else if ((column[i] == 'R' || column[i] == 'r') && !found) {
+                we = 0;
+                //Assign found and parsed variables to true and be sure that after the letter just space comes
+                found = 1;
+                parsed = 1;
+            } else if ((column[i] == 'I' || column[i] == 'i') && !found) {
+                // Instruction fetch, a read without data like 'r'
+                we = 0;
+                fetch = 1;
+                found = 1;
+                parsed = 1;
+            } else {
+                //Either no letter found or more than one
+                fprintf(stderr, "Invalid operation at line %zu found: ASCII: %.2x\n", requestCount + emptyLinesCount + 1, column[i]);
+                fclose(fp);
+                free(requests);
+                return 1;
+            }
+        }
+
+        // The column was empty
+        if (!parsed) {
+            fprintf(stderr, "No operation is found in line %zu.\n", requestCount + emptyLinesCount + 1);
+            fclose(fp);
+            free(requests);
+            return 1;
+        }
+
+        // Reading second column
+        if ((column = strtok(NULL,",")) == NULL) {
+            fprintf(stderr, "Invalid line at %zu found.\n", requestCount + emptyLinesCount + 1);
+            fclose(fp);
+            free(requests);
+            return 1;
+        }
+
+        // strtok() skip if two separator next to each other like ",,". So test if there was a ',' before token
+        if (column[-1] == ',') {
+            fprintf(stderr, "No address is found in line %zu.\n", requestCount + emptyLinesCount + 1);
+            fclose(fp);
+            free(requests);
+            return 1;
+        }
+
+
+        // After parsing, it should be 1
+        parsed = 0;
+        // Iterating second column
+        for (int i = 0; column[i] != '\0'; i++) {
+            if (isspace(column[i])) {
+                continue;
+            } else if (column[i] == '0' && (column[i + 1] == 'x' || column[i + 1] == 'X')) {
+                // If after '0' a 'X' comes try to convert hex
+                if (convert_hex_to_uint64_t(column, &address) != 0) {
+                    fclose(fp);
+                    free(requests);
+                    return 1;
+                }
+                // Update parsed variable
+                parsed = 1;
+                break;
+            } else {
+                // else try to convert to decimal
+                if (convert_dec_to_uint64_t(column, &address) != 0) {
+                    fclose(fp);
+                    free(requests);
+                    return 1;
+                }
+                // Update parsed variable
+                parsed = 1;
+                break;
+            }
+        }
+
+        // The column was empty
+        if (!parsed) {
+            fprintf(stderr, "No address is found in line %zu.\n", requestCount + emptyLinesCount + 1);
+            fclose(fp);
+            free(requests);
+            return 1;
+        }
+
+        /*
+         * Reading third and the optional fourth, fifth and sixth column
+         * For read operation the data can be NULL or after ',' just empty chars
+         * but not for write. The rest of the line is split by hand, because
+         * strtok() would skip the empty data column of a read with a size.
+         */
+        column = strtok(NULL, "");
+        char *sizeColumn = column != NULL ? strchr(column, ',') : NULL;
+        if (sizeColumn != NULL) {
+            *sizeColumn++ = '\0';
+        }
+        char *gapColumn = sizeColumn != NULL ? strchr(sizeColumn, ',') : NULL;
+        if (gapColumn != NULL) {
+            *gapColumn++ = '\0';
+        }
+        char *streamColumn = gapColumn != NULL ? strchr(gapColumn, ',') : NULL;
+        if (streamColumn != NULL) {
+            *streamColumn++ = '\0';
+        }
+
+        if (column == NULL && we == 1) {
+            fprintf(stderr, "At line %zu invalid write operation.\n", requestCount + emptyLinesCount + 1);
+            fclose(fp);
+            free(requests);
+            return 1;
+        }
+
+        // Access size in bytes, 4 if there is no fourth column or it is empty before a gap
+        uint32_t size = 4;
+        if (sizeColumn != NULL && !(gapColumn != NULL && is_empty_line(sizeColumn))) {
+            if (is_empty_line(sizeColumn)) {
+                fprintf(stderr, "No access size is found in line %zu.\n", requestCount + emptyLinesCount + 1);
+                fclose(fp);
+                free(requests);
+                return 1;
+            }
+            if (convert_dec_to_uint32_t(sizeColumn, &size) != 0) {
+                fclose(fp);
+                free(requests);
+                return 1;
+            }
+            if (size == 0 || size > 64 || (size & (size - 1)) != 0) {
+                fprintf(stderr, "Invalid access size %u at line %zu: must be 1, 2, 4, 8, 16, 32 or 64\n",
+                        size, requestCount + emptyLinesCount + 1);
+                fclose(fp);
+                free(requests);
+                return 1;
+            }
+        }
+
+        parsed = 0;
+
+        /*
+         * If it's not NULL it can have a value or empty. For write it must have
+         * a value but for read it must be empty if it's not NULL.
+        */
+        if (column != NULL) {
+            for (int i = 0; column[i] != '\0'; i++) {
+                if (isspace(column[i])) {
+                    continue;
+                } else if (we == 0) {
+                    /* This branch shows that the found character is
+                     * different from empty chars
+                     * and its illegal in a read operation
+                     * */
+                    fprintf(stderr, "A data (ASCII: %.2x) has been found for read operation at line %zu. Read operation can't have a data\n",
+                            column[i], requestCount + emptyLinesCount + 1);
+                    fclose(fp);
+                    free(requests);
+                    return 1;
+                } else if (size > 4) {
+                    // Request can't hold the value, these stores are only simulated without data
+                    if(check_wide_data(column, size) != 0) {
+                        fclose(fp);
+                        free(requests);
+                        return 1;
+                    }
+                    parsed = 1;
+                    break;
+                } else if (column[i] == '0' && (column[i + 1] == 'x' || column[i + 1] == 'X')) {
+                    if(convert_hex_to_uint32_t(column, &data) != 0) {
+                        fclose(fp);
+                        free(requests);
+                        return 1;
+                    }
+                    parsed = 1;
+                    break;
+                } else {
+                    if(convert_dec_to_uint32_t(column, &data) != 0) {
+                        fclose(fp);
+                        free(requests);
+                        return 1;
+                    }
+                    parsed = 1;
+                    break;
+                }
+            }
+        }
+
+        // The column was empty and not OK for write operation
+        if (!parsed && we == 1) {
+            fprintf(stderr, "At line %zu the write operation doesn't have a value.\n", requestCount + emptyLinesCount + 1);
+            fclose(fp);
+            free(requests);
+            return 1;
+        }
+
+        // Compute cycles before the request, 0 if there is no fifth column or it is empty before a stream
+        uint32_t gap = 0;
+        if (gapColumn != NULL && !(streamColumn != NULL && is_empty_line(gapColumn))) {
+            if (is_empty_line(gapColumn)) {
+                fprintf(stderr, "No gap is found in line %zu.\n", requestCount + emptyLinesCount + 1);
+                fclose(fp);
+                free(requests);
+                return 1;
+            }
+            if (convert_dec_to_uint32_t(gapColumn, &gap) != 0) {
+                fclose(fp);
+                free(requests);
+                return 1;
+            }
+        }
+
+        // Stream the request belongs to, 0 if there is no sixth column
+        uint32_t stream = 0;
+        if (streamColumn != NULL) {
+            // More than 6 columns are illegal
+            if (strchr(streamColumn, ',') != NULL) {
+                fprintf(stderr, "At line %zu too many arguments for operation.\n", requestCount + emptyLinesCount + 1);
+                fclose(fp);
+                free(requests);
+                return 1;
+            }
+            if (is_empty_line(streamColumn)) {
+                fprintf(stderr, "No stream is found in line %zu.\n", requestCount + emptyLinesCount + 1);
+                fclose(fp);
+                free(requests);
+                return 1;
+            }
+            if (convert_dec_to_uint32_t(streamColumn, &stream) != 0) {
+                fclose(fp);
+                free(requests);
+                return 1;
+            }
+            if (stream >= MAX_STREAMS) {
+                fprintf(stderr, "Invalid stream %u at line %zu: must be below %u\n",
+                        stream, requestCount + emptyLinesCount + 1, MAX_STREAMS);
+                fclose(fp);
+                free(requests);
+                return 1;
+            }
+        }
+
+        // Narrow writes can't hold more than their bytes
+        if (size < 4 && (data >> (8 * size)) != 0) {
+            fprintf(stderr, "At line %zu the data doesn't fit into %u bytes.\n", requestCount + emptyLinesCount + 1, size);
+            fclose(fp);
+            free(requests);
+            return 1;
+        }
+
+
+        // Updating request members
+        requests[requestCount].addr = address;
+        requests[requestCount].we = we;
+        requests[requestCount].data = data;
+        requests[requestCount].size = size;
+        requests[requestCount].fetch = fetch;
+        requests[requestCount].gap = gap;
+        requests[requestCount].stream = stream;
+
+        // Next request, next line
+        requestCount++;
+    }
+    fclose(fp);
+
+    *requestsResult = requests;
+    *requestCountResult = requestCount;
+    return 0;
+}
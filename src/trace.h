@@ -0,0 +1,21 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "helper_structs/request.h"
+
+// Checks the .csv extension of a trace file
+int is_csv_file(const char *filename);
+
+/* Parses the requests of a csv trace file into a newly allocated array. Every line has the form
+ * <r|w|i>,<address>,<data>[,<size>[,<gap>[,<stream>]]] with i for an instruction fetch, the data is empty for reads and fetches and size is 1, 2, 4 (default), 8, 16, 32 or 64 bytes.
+ * Addresses have up to 64 bits.
+ * gap is the number of compute cycles the CPU idles before the request (default 0) and stream the tenant the
+ * request belongs to (default 0, below MAX_STREAMS). Size and gap may be left empty before a later column.
+ * Everything after '#' is a comment.
+ * Returns 1 with a message on stderr if the file can't be read or has an invalid line. */
+int read_trace(const char *filename, struct Request **requests, size_t *requestCount);
+
+#endif
@@ -0,0 +1,80 @@
+#ifndef FAST_DIVIDER_HPP
+#define FAST_DIVIDER_HPP
+
+#include <cstdint>
+
+/* Division by a divisor that is only known at runtime, without a div instruction on the hot path.
+ * A power of 2 shifts and masks like before. 32-bit dividends of every other divisor multiply with
+ * the precomputed multiplier ceil(2^64 / divisor) and keep the upper 64 bits of the product
+ * (Lemire's fastmod), which is exact for every 32-bit dividend. 64-bit dividends use a 65-bit
+ * multiplier split into 64 bits and an add step (the round-up method of libdivide). */
+struct FastDivider {
+    uint32_t divisor = 1;
+    uint64_t multiplier = 0;
+    // log2 of a power of 2 divisor, floor(log2) of every other
+    unsigned shift = 0;
+    bool powerOfTwo = true;
+
+    // multiplier of 64-bit dividends and whether the 65th bit needs the add step
+    uint64_t wideMultiplier = 0;
+    bool wideAdd = false;
+
+    FastDivider() {}
+    explicit FastDivider(uint32_t divisor) :
+    divisor(divisor), multiplier(UINT64_MAX / divisor + 1), powerOfTwo((divisor & (divisor - 1)) == 0) {
+        while((divisor >> shift) > 1) {
+            ++shift;
+        }
+        if(!powerOfTwo) {
+            unsigned __int128 numerator = (unsigned __int128)1 << (64 + shift);
+            uint64_t proposed = (uint64_t)(numerator / divisor);
+            uint64_t remainder = (uint64_t)(numerator % divisor);
+            if(divisor - remainder < ((uint64_t)1 << shift)) {
+                wideMultiplier = proposed + 1;
+            } else {
+                uint64_t twiceRemainder = remainder + remainder;
+                proposed += proposed;
+                if(twiceRemainder >= divisor || twiceRemainder < remainder) {
+                    ++proposed;
+                }
+                wideMultiplier = proposed + 1;
+                wideAdd = true;
+            }
+        }
+    }
+
+    uint32_t quotient(uint32_t n) const {
+        if(powerOfTwo) {
+            return n >> shift;
+        }
+        return (uint32_t)(((unsigned __int128)multiplier * n) >> 64);
+    }
+
+    uint32_t remainder(uint32_t n) const {
+        if(powerOfTwo) {
+            return n & (divisor - 1);
+        }
+        // the lower 64 bits of the product are the fraction of n / divisor
+        return (uint32_t)(((unsigned __int128)(multiplier * n) * divisor) >> 64);
+    }
+
+    uint64_t quotient(uint64_t n) const {
+        if(powerOfTwo) {
+            return n >> shift;
+        }
+        uint64_t high = (uint64_t)(((unsigned __int128)wideMultiplier * n) >> 64);
+        if(wideAdd) {
+            return (((n - high) >> 1) + high) >> shift;
+        }
+        return high >> shift;
+    }
+
+    uint64_t remainder(uint64_t n) const {
+        if(powerOfTwo) {
+            return n & (divisor - 1);
+        }
+        return n - quotient(n) * divisor;
+    }
+};
+
+#endif
@@ -0,0 +1,125 @@
+#ifndef GATE_COUNT_HPP
+#define GATE_COUNT_HPP
+
+#include <cstddef>
+
+#include "../helper_structs/index_function.h"
+
+/* Self created logarithm without using double or float
+ * so that narrowing conversation never happens. */
+inline unsigned log2(unsigned a) {
+    unsigned digits = 0;
+    while (a > 1) {
+        a >>= 1;
+        digits++;
+    }
+    return digits;
+}
+
+// Bits to select one of a things, log2() rounded up
+inline unsigned log2Ceil(unsigned a) {
+    unsigned digits = log2(a);
+    return (1u << digits) < a ? digits + 1 : digits;
+}
+
+/* Primitive gate count calculation based on the inputs for cacheLines and cacheLineSize, rounded up to hundreds.
+ * A number of sets that isn't a power of 2 rounds the multiplexer select up and the tag, the quotient of the
+ * line address, down; its modulo unit is part of calculateIndexHashGateCount(). The tags and comparators
+ * follow the configured addressBits of the hardware, the data path the 32-bit data word of a request. */
+inline size_t calculatePrimitiveGateCount(int directMapped, unsigned cacheLines, unsigned cacheLineSize,
+                                          unsigned addressBits = 32) {
+    size_t primitiveGateCount = 0;
+    unsigned offsetBitsCount = log2(cacheLineSize);
+    const unsigned dataBits = 32;
+
+    if(directMapped) {
+        unsigned indexBitsCount = log2(cacheLines);
+        // 2 Multiplexers
+        primitiveGateCount += log2Ceil(cacheLines) * 4 * 2;
+        // 1 Comparator
+        primitiveGateCount += (addressBits - indexBitsCount - offsetBitsCount) * 2;
+        // for each bit in cache 1 SRAM (2 gates) for data and tag
+        primitiveGateCount += (cacheLines * 2 * (cacheLineSize * 8 + addressBits - indexBitsCount - offsetBitsCount));
+    } else {
+        unsigned numberOfSets = cacheLines / 4;
+        unsigned setIndexBitsCount = log2(numberOfSets);
+        //2 numberOfSets-to-1 multiplexers
+        primitiveGateCount += log2Ceil(numberOfSets) * 4 * 2;
+        //4 tag comparators
+        primitiveGateCount += (2 * (addressBits - setIndexBitsCount - offsetBitsCount)) * 4;
+        //4 3-state-buffers of the data word, one per way
+        primitiveGateCount += dataBits * 3 * 4;
+        //for each bit in cache 1 SRAM (2 gates) for data and tag
+        primitiveGateCount += (cacheLines * 2 * (cacheLineSize * 8 + addressBits - setIndexBitsCount - offsetBitsCount));
+        //replace algorithm
+        primitiveGateCount += numberOfSets * 110;
+    }
+
+    return primitiveGateCount + (100 - (primitiveGateCount % 100)); // just round up
+}
+
+/* Additional gates of sectored lines: one more valid bit SRAM (2 gates) for every sector but the first
+ * and a multiplexer selecting the valid bit of the accessed sector, rounded up to hundreds. */
+inline size_t calculateSectorGateCount(unsigned cacheLines, unsigned cacheLineSize, unsigned sectorSize) {
+    unsigned sectors = cacheLineSize / sectorSize;
+    if(sectors <= 1) {
+        return 0;
+    }
+
+    size_t sectorGateCount = (size_t)cacheLines * (sectors - 1) * 2 + log2(sectors) * 4;
+    return sectorGateCount + (100 - (sectorGateCount % 100)); // just round up
+}
+
+/* Gates of a TLB level of entries in sets of ways: for every entry 1 SRAM (2 gates) for the valid bit,
+ * the page number and the frame number, and a comparator per way, rounded up to hundreds. */
+inline size_t calculateTlbGateCount(unsigned entries, unsigned ways, unsigned pageSize, unsigned addressBits = 32) {
+    if(entries == 0) {
+        return 0;
+    }
+    unsigned pageNumberBitsCount = addressBits - log2(pageSize);
+
+    size_t tlbGateCount = (size_t)entries * 2 * (1 + 2 * pageNumberBitsCount);
+    tlbGateCount += (size_t)ways * pageNumberBitsCount * 2;
+    return tlbGateCount + (100 - (tlbGateCount % 100)); // just round up
+}
+
+/* Additional gates of an index function compared to the bit slice of a power of 2 sets, rounded up to hundreds.
+ * A 2-input XOR counts as 3 gates (2 AND, 1 OR) and a full adder as 5 gates. */
+inline size_t calculateIndexHashGateCount(enum IndexFunction function, int directMapped, unsigned cacheLines,
+                                          unsigned cacheLineSize, unsigned addressBits = 32) {
+    size_t indexHashGateCount = 0;
+    unsigned lineBitsCount = addressBits - log2(cacheLineSize);
+    unsigned numberOfSets = directMapped ? cacheLines : cacheLines / 4;
+    unsigned indexBitsCount = log2Ceil(numberOfSets);
+    if(indexBitsCount == 0) {
+        return 0;
+    }
+
+    switch(function) {
+        case INDEX_BITSLICE:
+            if((numberOfSets & (numberOfSets - 1)) == 0) {
+                return 0;
+            }
+            // the line address modulo the sets by the same residue tree as INDEX_PRIME, the quotient is the tag
+            indexHashGateCount = (size_t)(lineBitsCount - indexBitsCount + 1) * (indexBitsCount + 1) * 5;
+            break;
+        case INDEX_XOR:
+            // every line address bit above the index is XORed into one index bit
+            indexHashGateCount = (size_t)(lineBitsCount - indexBitsCount) * 3;
+            break;
+        case INDEX_PRIME:
+            // the residues of the upper bits summed by a carry save adder tree and a final reduction
+            indexHashGateCount = (size_t)(lineBitsCount - indexBitsCount + 1) * (indexBitsCount + 1) * 5;
+            break;
+        case INDEX_SKEWED:
+            // one XOR row per way (the rotation is only wiring) and 3 more set multiplexers
+            indexHashGateCount = (size_t)4 * indexBitsCount * 3 + (size_t)3 * indexBitsCount * 4 * 2;
+            break;
+        default:
+            return 0;
+    }
+
+    return indexHashGateCount + (100 - (indexHashGateCount % 100)); // just round up
+}
+
+#endif
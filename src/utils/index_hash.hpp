@@ -0,0 +1,93 @@
+#ifndef INDEX_HASH_HPP
+#define INDEX_HASH_HPP
+
+#include <cstdint>
+
+#include "../helper_structs/index_function.h"
+#include "fast_divider.hpp"
+
+/* Maps addresses to sets and tags for a selectable index function.
+ * With the bit slice the tag is made of the bits above the index like before. For a number of
+ * sets that isn't a power of 2 the bit slice becomes the line address modulo the sets and the
+ * tag its quotient, both by multiply-shift. XOR and skewed need a power of 2. Every other
+ * function can send lines with equal upper bits to different sets, so the tag is the whole
+ * line address there. */
+struct IndexHash {
+    IndexFunction function = INDEX_BITSLICE;
+    unsigned offsetBitsCount = 0, indexBitsCount = 0;
+    uint32_t indexMask = 0;
+    // divisor of INDEX_PRIME
+    uint32_t modulus = 1;
+    // divisor of the bit slice
+    FastDivider sets;
+
+    IndexHash() {}
+    IndexHash(IndexFunction function, unsigned offsetBitsCount, uint32_t numberOfSets) :
+    function(function), offsetBitsCount(offsetBitsCount), indexBitsCount(ceilLog2(numberOfSets)),
+    indexMask((1u << indexBitsCount) - 1), modulus(largestPrimeAtMost(numberOfSets)), sets(numberOfSets) {}
+
+    static unsigned ceilLog2(uint32_t n) {
+        unsigned bits = 0;
+        while(bits < 32 && (1u << bits) < n) {
+            ++bits;
+        }
+        return bits;
+    }
+
+    static uint32_t largestPrimeAtMost(uint32_t n) {
+        for(; n > 2; --n) {
+            bool prime = n % 2 != 0;
+            for(uint32_t d = 3; prime && d * d <= n; d += 2) {
+                prime = n % d != 0;
+            }
+            if(prime) {
+                return n;
+            }
+        }
+        return n;
+    }
+
+    // Rotates the index bits of value left by count
+    uint32_t rotateIndex(uint32_t value, unsigned count) const {
+        count %= indexBitsCount;
+        if(count == 0) {
+            return value;
+        }
+        return ((value << count) | (value >> (indexBitsCount - count))) & indexMask;
+    }
+
+    // Set of address in the given way, only INDEX_SKEWED depends on the way
+    uint32_t index(uint64_t address, unsigned way = 0) const {
+        uint64_t line = address >> offsetBitsCount;
+        if(indexBitsCount == 0) {
+            return 0;
+        }
+
+        switch(function) {
+            case INDEX_XOR: {
+                uint32_t index = 0;
+                for(; line != 0; line >>= indexBitsCount) {
+                    index ^= (uint32_t)(line & indexMask);
+                }
+                return index;
+            }
+            case INDEX_PRIME:
+                return (uint32_t)(line % modulus);
+            case INDEX_SKEWED:
+                return rotateIndex((uint32_t)(line & indexMask), way) ^ (uint32_t)((line >> indexBitsCount) & indexMask);
+            default:
+                // lines of 32-bit addresses take the cheaper 32-bit division
+                return line <= UINT32_MAX ? sets.remainder((uint32_t)line) : (uint32_t)sets.remainder(line);
+        }
+    }
+
+    uint64_t tag(uint64_t address) const {
+        uint64_t line = address >> offsetBitsCount;
+        if(function != INDEX_BITSLICE) {
+            return line;
+        }
+        return line <= UINT32_MAX ? sets.quotient((uint32_t)line) : sets.quotient(line);
+    }
+};
+
+#endif
@@ -0,0 +1,103 @@
+#ifndef INTERVAL_STATISTICS_HPP
+#define INTERVAL_STATISTICS_HPP
+
+#include <cstddef>
+#include <fstream>
+
+/* Time series of the counters of a cache model for phase detection. The cache module calls advance()
+ * when a request reaches it, which closes the intervals that ended before: after every length requests or,
+ * counted in cycles, at every multiple of length cycles. Each closed interval is written to the file right
+ * away as a CSV row or an element of a JSON array, so it can be followed while a long trace is simulated.
+ * Works with any model that counts hits, misses, evictions and validLines (DirectMappedModel, FourWayModel). */
+struct IntervalStatistics {
+
+    size_t length;
+    bool inCycles, json;
+
+    // Capacity of the cache, gives the occupancy as the fraction of valid lines
+    unsigned cacheLines;
+
+    std::ofstream out;
+
+    // Intervals written so far and the requests of the current one
+    size_t intervals = 0, requests = 0;
+
+    // Cycle and counters of the model at the start of the current interval
+    size_t startCycle = 0, hits = 0, misses = 0, evictions = 0;
+
+    IntervalStatistics(const char* filename, bool json, size_t length, bool inCycles, unsigned cacheLines) :
+    length(length), inCycles(inCycles), json(json), cacheLines(cacheLines), out(filename) {
+        if(json) {
+            out << "[";
+        } else {
+            out << "interval,requests,start_cycle,cycles,hits,misses,evictions,valid_lines,occupancy\n";
+        }
+    }
+
+    // Counters after the warm-up, the first interval starts at cycle 0
+    template<typename Model>
+    void begin(const Model& model) {
+        hits = model.hits;
+        misses = model.misses;
+        evictions = model.evictions;
+    }
+
+    // A request reaches the cache at cycle now, it belongs to the interval that is open afterwards
+    template<typename Model>
+    void advance(const Model& model, size_t now) {
+        if(inCycles) {
+            // Intervals without a request in between are written as well
+            while(now >= startCycle + length) {
+                close(model, startCycle + length);
+            }
+        } else if(requests == length) {
+            close(model, now);
+        }
+        ++requests;
+    }
+
+    // Writes the last, partial interval ending at cycle end and finishes the file, false on a write error
+    template<typename Model>
+    bool finish(const Model& model, size_t end) {
+        if(requests > 0 || end > startCycle) {
+            close(model, end > startCycle ? end : startCycle);
+        }
+        if(json) {
+            out << (intervals > 0 ? "\n]\n" : "]\n");
+        }
+        out.flush();
+        return (bool)out;
+    }
+
+    template<typename Model>
+    void close(const Model& model, size_t end) {
+        size_t
+        cycles = end - startCycle,
+        intervalHits = model.hits - hits,
+        intervalMisses = model.misses - misses,
+        intervalEvictions = model.evictions - evictions;
+        double occupancy = (double)model.validLines / cacheLines;
+
+        if(json) {
+            out << (intervals > 0 ? ",\n  " : "\n  ")
+                << "{\"interval\": " << intervals << ", \"requests\": " << requests
+                << ", \"start_cycle\": " << startCycle << ", \"cycles\": " << cycles
+                << ", \"hits\": " << intervalHits << ", \"misses\": " << intervalMisses
+                << ", \"evictions\": " << intervalEvictions << ", \"valid_lines\": " << model.validLines
+                << ", \"occupancy\": " << occupancy << "}";
+        } else {
+            out << intervals << ',' << requests << ',' << startCycle << ',' << cycles << ','
+                << intervalHits << ',' << intervalMisses << ',' << intervalEvictions << ','
+                << model.validLines << ',' << occupancy << '\n';
+        }
+        // Every interval reaches the file before the simulation goes on
+        out.flush();
+
+        ++intervals;
+        requests = 0;
+        startCycle = end;
+        begin(model);
+    }
+};
+
+#endif
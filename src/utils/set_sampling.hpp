@@ -0,0 +1,71 @@
+#ifndef SET_SAMPLING_HPP
+#define SET_SAMPLING_HPP
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "../helper_structs/set_statistics.hpp"
+
+/* Scrambles a set index (murmur3 finalizer) so that the sampled sets are spread
+ * over the whole cache instead of forming one contiguous block. */
+inline uint32_t hashSetIndex(uint32_t setIndex) {
+    setIndex ^= setIndex >> 16;
+    setIndex *= 0x85ebca6b;
+    setIndex ^= setIndex >> 13;
+    setIndex *= 0xc2b2ae35;
+    setIndex ^= setIndex >> 16;
+    return setIndex;
+}
+
+inline bool isSampledSet(uint32_t setIndex, unsigned sampleRate) {
+    return sampleRate <= 1 || hashSetIndex(setIndex) % sampleRate == 0;
+}
+
+// Extrapolated total of a counter together with the half-width of its 95% confidence interval
+struct SampledEstimate {
+    double value;
+    double margin;
+};
+
+/* Ratio estimator for cluster sampling: every sampled set is one cluster.
+ * The per-request rate of the counter is measured on the sampled sets and scaled
+ * to all requests of the trace. The variance uses the usual first-order
+ * approximation including the finite population correction over the sets. */
+inline SampledEstimate extrapolate(const std::vector<uint32_t>& sampledSets,
+                                   const std::vector<SetStatistics>& statistics,
+                                   size_t SetStatistics::*counter,
+                                   unsigned numberOfSets,
+                                   size_t totalRequests) {
+    double sampledAccesses = 0, sampledCount = 0;
+    for(uint32_t set : sampledSets) {
+        sampledAccesses += statistics[set].accesses;
+        sampledCount += statistics[set].*counter;
+    }
+
+    // Nothing landed in the sampled sets, so there is nothing to scale
+    if(sampledAccesses == 0) {
+        return SampledEstimate {0, NAN};
+    }
+
+    double ratio = sampledCount / sampledAccesses;
+    double k = sampledSets.size();
+    if(k < 2) {
+        return SampledEstimate {ratio * totalRequests, NAN};
+    }
+
+    // Squared residuals of every set against the common ratio
+    double residuals = 0;
+    for(uint32_t set : sampledSets) {
+        double accesses = statistics[set].accesses, count = statistics[set].*counter;
+        residuals += (count - ratio * accesses) * (count - ratio * accesses);
+    }
+
+    double meanAccesses = sampledAccesses / k;
+    double fpc = 1.0 - k / numberOfSets;
+    double variance = fpc * residuals / (k - 1) / (k * meanAccesses * meanAccesses);
+
+    return SampledEstimate {ratio * totalRequests, 1.96 * std::sqrt(variance) * totalRequests};
+}
+
+#endif
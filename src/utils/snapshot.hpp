@@ -0,0 +1,77 @@
+#ifndef SNAPSHOT_HPP
+#define SNAPSHOT_HPP
+
+#include <cstdint>
+#include <istream>
+#include <map>
+#include <ostream>
+
+#include "../helper_structs/cache_line.hpp"
+
+/* Binary snapshot of the cache and main memory state.
+ * Layout: magic, version, cache geometry and address width, followed by the state written by the
+ * cache module itself. Values are stored in host byte order. */
+const char snapshotMagic[4] = {'C', 'S', 'I', 'M'};
+// 2: 64-bit tags and main memory addresses
+// 3: tags and main memory addresses of the width given in the header
+const uint32_t snapshotVersion = 3;
+
+template<typename T>
+void writeSnapshotValue(std::ostream& out, T value) {
+    out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template<typename T>
+bool readSnapshotValue(std::istream& in, T& value) {
+    return (bool)in.read(reinterpret_cast<char*>(&value), sizeof(T));
+}
+
+/* Only the bytes that were ever touched are stored, like in the maps themselves.
+ * Main memory has addresses of the model's width, the data of a line 32-bit offsets. */
+template<typename Address>
+void writeSnapshotBytes(std::ostream& out, const std::map<Address, uint8_t>& bytes) {
+    writeSnapshotValue<uint64_t>(out, bytes.size());
+    for(const auto& byte : bytes) {
+        writeSnapshotValue<Address>(out, byte.first);
+        writeSnapshotValue<uint8_t>(out, byte.second);
+    }
+}
+
+template<typename Address>
+bool readSnapshotBytes(std::istream& in, std::map<Address, uint8_t>& bytes) {
+    uint64_t count;
+    if(!readSnapshotValue(in, count)) {
+        return false;
+    }
+    bytes.clear();
+    for(uint64_t i = 0; i < count; ++i) {
+        Address address;
+        uint8_t value;
+        if(!readSnapshotValue(in, address) || !readSnapshotValue(in, value)) {
+            return false;
+        }
+        bytes.emplace_hint(bytes.end(), address, value);
+    }
+    return true;
+}
+
+template<typename Tag>
+void writeSnapshotLine(std::ostream& out, const CacheLine<Tag>& line) {
+    writeSnapshotValue<Tag>(out, line.tag);
+    writeSnapshotValue<uint8_t>(out, line.valid);
+    writeSnapshotBytes(out, line.data);
+}
+
+template<typename Tag>
+bool readSnapshotLine(std::istream& in, CacheLine<Tag>& line) {
+    Tag tag;
+    uint8_t valid;
+    if(!readSnapshotValue(in, tag) || !readSnapshotValue(in, valid)) {
+        return false;
+    }
+    line.tag = tag;
+    line.valid = valid;
+    return readSnapshotBytes(in, line.data);
+}
+
+#endif
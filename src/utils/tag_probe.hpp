@@ -0,0 +1,171 @@
+#ifndef TAG_PROBE_HPP
+#define TAG_PROBE_HPP
+
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define TAG_PROBE_X86
+#endif
+
+/* Compares a tag against all ways of a set at once.
+ * The tags of a set have to lie next to each other. SSE2 is part of every x86-64 CPU,
+ * so the four ways of the four-way cache are compared inline without any dispatch.
+ * Only sets with more ways choose AVX2 once at runtime by CPUID, everything without
+ * SSE2 falls back to a scalar loop. */
+
+// Returns a bit mask with bit w set if tags[w] == tag
+typedef uint32_t (*TagMatchFunction)(const uint32_t* tags, unsigned ways, uint32_t tag);
+
+inline uint32_t matchTagsScalar(const uint32_t* tags, unsigned ways, uint32_t tag) {
+    uint32_t mask = 0;
+    for(unsigned w = 0; w < ways; ++w) {
+        mask |= (uint32_t)(tags[w] == tag) << w;
+    }
+    return mask;
+}
+
+#ifdef __SSE2__
+inline uint32_t matchTags4(const uint32_t* tags, uint32_t tag) {
+    __m128i equal = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*)tags), _mm_set1_epi32((int)tag));
+    return (uint32_t)_mm_movemask_ps(_mm_castsi128_ps(equal));
+}
+
+inline uint32_t matchTagsSse2(const uint32_t* tags, unsigned ways, uint32_t tag) {
+    uint32_t mask = 0;
+    unsigned w = 0;
+    for(; w + 4 <= ways; w += 4) {
+        mask |= matchTags4(tags + w, tag) << w;
+    }
+    // A shift by all 32 ways would be undefined
+    return w < ways ? mask | (matchTagsScalar(tags + w, ways - w, tag) << w) : mask;
+}
+#else
+inline uint32_t matchTags4(const uint32_t* tags, uint32_t tag) {
+    return matchTagsScalar(tags, 4, tag);
+}
+
+inline uint32_t matchTagsSse2(const uint32_t* tags, unsigned ways, uint32_t tag) {
+    return matchTagsScalar(tags, ways, tag);
+}
+#endif
+
+#ifdef TAG_PROBE_X86
+__attribute__((target("avx2")))
+inline uint32_t matchTagsAvx2(const uint32_t* tags, unsigned ways, uint32_t tag) {
+    __m256i key = _mm256_set1_epi32((int)tag);
+    uint32_t mask = 0;
+    unsigned w = 0;
+    for(; w + 8 <= ways; w += 8) {
+        __m256i equal = _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i*)(tags + w)), key);
+        mask |= (uint32_t)_mm256_movemask_ps(_mm256_castsi256_ps(equal)) << w;
+    }
+    return w < ways ? mask | (matchTagsSse2(tags + w, ways - w, tag) << w) : mask;
+}
+#endif
+
+// The same for the 64-bit tags of traces with addresses above 4 GB, half as many ways per instruction
+typedef uint32_t (*WideTagMatchFunction)(const uint64_t* tags, unsigned ways, uint64_t tag);
+
+inline uint32_t matchWideTagsScalar(const uint64_t* tags, unsigned ways, uint64_t tag) {
+    uint32_t mask = 0;
+    for(unsigned w = 0; w < ways; ++w) {
+        mask |= (uint32_t)(tags[w] == tag) << w;
+    }
+    return mask;
+}
+
+#ifdef __SSE2__
+/* SSE2 has no 64-bit compare: a tag matches if both of its 32-bit halves do,
+ * so every half is combined with its neighbour before taking one bit per tag. */
+inline uint32_t matchWideTags2(const uint64_t* tags, __m128i key) {
+    __m128i equal = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*)tags), key);
+    equal = _mm_and_si128(equal, _mm_shuffle_epi32(equal, _MM_SHUFFLE(2, 3, 0, 1)));
+    return (uint32_t)_mm_movemask_pd(_mm_castsi128_pd(equal));
+}
+
+inline uint32_t matchWideTags4(const uint64_t* tags, uint64_t tag) {
+    __m128i key = _mm_set1_epi64x((long long)tag);
+    return matchWideTags2(tags, key) | matchWideTags2(tags + 2, key) << 2;
+}
+
+inline uint32_t matchWideTagsSse2(const uint64_t* tags, unsigned ways, uint64_t tag) {
+    __m128i key = _mm_set1_epi64x((long long)tag);
+    uint32_t mask = 0;
+    unsigned w = 0;
+    for(; w + 2 <= ways; w += 2) {
+        mask |= matchWideTags2(tags + w, key) << w;
+    }
+    return w < ways ? mask | (matchWideTagsScalar(tags + w, ways - w, tag) << w) : mask;
+}
+#else
+inline uint32_t matchWideTags4(const uint64_t* tags, uint64_t tag) {
+    return matchWideTagsScalar(tags, 4, tag);
+}
+
+inline uint32_t matchWideTagsSse2(const uint64_t* tags, unsigned ways, uint64_t tag) {
+    return matchWideTagsScalar(tags, ways, tag);
+}
+#endif
+
+#ifdef TAG_PROBE_X86
+__attribute__((target("avx2")))
+inline uint32_t matchWideTagsAvx2(const uint64_t* tags, unsigned ways, uint64_t tag) {
+    __m256i key = _mm256_set1_epi64x((long long)tag);
+    uint32_t mask = 0;
+    unsigned w = 0;
+    for(; w + 4 <= ways; w += 4) {
+        __m256i equal = _mm256_cmpeq_epi64(_mm256_loadu_si256((const __m256i*)(tags + w)), key);
+        mask |= (uint32_t)_mm256_movemask_pd(_mm256_castsi256_pd(equal)) << w;
+    }
+    return w < ways ? mask | (matchWideTagsSse2(tags + w, ways - w, tag) << w) : mask;
+}
+#endif
+
+inline TagMatchFunction selectTagMatch() {
+#ifdef TAG_PROBE_X86
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx2")) {
+        return matchTagsAvx2;
+    }
+#endif
+    return matchTagsSse2;
+}
+
+inline WideTagMatchFunction selectWideTagMatch() {
+#ifdef TAG_PROBE_X86
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx2")) {
+        return matchWideTagsAvx2;
+    }
+#endif
+    return matchWideTagsSse2;
+}
+
+/* Returns the first way of a set whose tag matches and whose bit in validMask is set,
+ * -1 if the tag isn't in the set. At most 32 ways are supported. */
+inline int findWay(const uint32_t* tags, unsigned ways, uint32_t validMask, uint32_t tag) {
+    uint32_t mask;
+    if(ways == 4) {
+        mask = matchTags4(tags, tag);
+    } else {
+        static const TagMatchFunction matchTags = selectTagMatch();
+        mask = matchTags(tags, ways, tag);
+    }
+    mask &= validMask;
+    return mask ? __builtin_ctz(mask) : -1;
+}
+
+inline int findWay(const uint64_t* tags, unsigned ways, uint32_t validMask, uint64_t tag) {
+    uint32_t mask;
+    if(ways == 4) {
+        mask = matchWideTags4(tags, tag);
+    } else {
+        static const WideTagMatchFunction matchTags = selectWideTagMatch();
+        mask = matchTags(tags, ways, tag);
+    }
+    mask &= validMask;
+    return mask ? __builtin_ctz(mask) : -1;
+}
+
+#endif
@@ -0,0 +1,108 @@
+/* Checks that the engines without SystemC decide like the models of the SystemC caches.
+ * DirectMappedModel and FourWayModel are the state of the pin-level and TLM caches, so every
+ * request has to fetch as many lines from them as from FunctionalCache, and the 64-bit variants
+ * as many as WideFunctionalCache. The set-partitioned parallel engine has to give the same cycles,
+ * hits and misses as a serial replay of FunctionalCache with CpuTiming, for any number of threads. */
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "../src/models/direct_mapped_model.hpp"
+#include "../src/models/four_way_model.hpp"
+#include "../src/engine/functional_cache.hpp"
+#include "../src/engine/parallel_simulation.hpp"
+
+static size_t failures = 0, checks = 0;
+
+static void fail(const char* what, bool directMapped, unsigned sets, unsigned lineSize) {
+    if(++failures <= 10) {
+        fprintf(stderr, "%s differs for %s with %u sets of %u bytes\n", what,
+                directMapped ? "direct-mapped" : "four-way", sets, lineSize);
+    }
+}
+
+/* Reads and writes of every size, some of them crossing lines, on four regions of 8 KB that lie
+ * regionDistance bytes apart. Together they are a few times the size of the caches, so there are
+ * hits, misses and evictions. */
+static std::vector<Request> makeTrace(std::mt19937_64& random, size_t count, uint64_t regionDistance) {
+    static const unsigned sizes[] = {1, 2, 4, 4, 8, 16, 64};
+    std::vector<Request> requests(count);
+    for(Request& request : requests) {
+        request = Request();
+        request.addr = random() % 4 * regionDistance + (random() & 0x1FFF);
+        request.size = sizes[random() % 7];
+        request.we = random() % 4 == 0;
+        request.gap = random() % 3;
+    }
+    return requests;
+}
+
+template<typename Cache, typename Model>
+static void compareModel(Model& model, const std::vector<Request>& requests, bool directMapped, unsigned sets,
+                         unsigned lineSize, unsigned offsetBitsCount) {
+    Cache cache(directMapped, offsetBitsCount, sets);
+    model.trackData = false;
+    ++checks;
+    for(size_t i = 0; i < requests.size(); ++i) {
+        Request request = requests[i];
+        unsigned modelLines = request.we ? model.writeData(request.addr, 0, request.size)
+                                         : model.readData(request.addr, request.data, request.size);
+        if(modelLines != cache.accessRequest(request)) {
+            fail("Fetched lines of the model", directMapped, sets, lineSize);
+            return;
+        }
+    }
+}
+
+template<typename Cache>
+static void compareParallel(const std::vector<Request>& requests, bool directMapped, unsigned sets,
+                            unsigned lineSize, unsigned offsetBitsCount) {
+    Cache cache(directMapped, offsetBitsCount, sets);
+    CpuTiming timing(1000000000, 1, 200);
+    for(const Request& request : requests) {
+        timing.addRequests(&request, 1, cache.accessRequest(request));
+    }
+    Result serial = timing.result();
+
+    for(unsigned threads : {1u, 3u, 4u}) {
+        ++checks;
+        Result parallel = runParallelSimulation<Cache>(1000000000, directMapped, offsetBitsCount, sets, 1, 200,
+                                                       requests.size(), requests.data(), 0, threads);
+        if(parallel.cycles != serial.cycles || parallel.hits != serial.hits || parallel.misses != serial.misses) {
+            fail("Result of the parallel engine", directMapped, sets, lineSize);
+        }
+    }
+}
+
+int main() {
+    std::mt19937_64 random(7);
+
+    // Powers of 2 are bit slices, the other set counts take the line address modulo the sets
+    for(unsigned sets : {64u, 96u, 100u}) {
+        for(unsigned lineSize : {16u, 64u}) {
+            unsigned offsetBitsCount = lineSize == 16 ? 4 : 6;
+
+            std::vector<Request> requests = makeTrace(random, 50000, 0x40000);
+            DirectMappedModel directMappedModel(lineSize, offsetBitsCount, lineSize - 1, sets);
+            compareModel<FunctionalCache>(directMappedModel, requests, true, sets, lineSize, offsetBitsCount);
+            FourWayModel fourWayModel(lineSize, offsetBitsCount, lineSize - 1, sets);
+            compareModel<FunctionalCache>(fourWayModel, requests, false, sets, lineSize, offsetBitsCount);
+            compareParallel<FunctionalCache>(requests, true, sets, lineSize, offsetBitsCount);
+            compareParallel<FunctionalCache>(requests, false, sets, lineSize, offsetBitsCount);
+
+            // Addresses of 64-bit processes with tags above 32 bits
+            std::vector<Request> wideRequests = makeTrace(random, 50000, (uint64_t)1 << 40);
+            WideDirectMappedModel wideDirectMappedModel(lineSize, offsetBitsCount, lineSize - 1, sets);
+            compareModel<WideFunctionalCache>(wideDirectMappedModel, wideRequests, true, sets, lineSize, offsetBitsCount);
+            WideFourWayModel wideFourWayModel(lineSize, offsetBitsCount, lineSize - 1, sets);
+            compareModel<WideFunctionalCache>(wideFourWayModel, wideRequests, false, sets, lineSize, offsetBitsCount);
+            compareParallel<WideFunctionalCache>(wideRequests, true, sets, lineSize, offsetBitsCount);
+            compareParallel<WideFunctionalCache>(wideRequests, false, sets, lineSize, offsetBitsCount);
+        }
+    }
+
+    printf("engines: %zu of %zu comparisons differ\n", failures, checks);
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,81 @@
+/* Compares FastDivider with the / and % of the compiler, for 32- and 64-bit dividends:
+ * every small dividend, the dividends next to 2^32 and 2^64 and random ones, for the
+ * divisors of typical set counts, every power of 2 and random divisors. */
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "../src/utils/fast_divider.hpp"
+
+static size_t failures = 0, comparisons = 0;
+
+static void check(const FastDivider& divider, uint64_t n) {
+    uint32_t divisor = divider.divisor;
+    ++comparisons;
+    if(divider.quotient(n) != n / divisor || divider.remainder(n) != n % divisor) {
+        if(++failures <= 10) {
+            fprintf(stderr, "%llu / %u: quotient %llu remainder %llu instead of %llu and %llu\n",
+                    (unsigned long long)n, divisor, (unsigned long long)divider.quotient(n),
+                    (unsigned long long)divider.remainder(n), (unsigned long long)(n / divisor),
+                    (unsigned long long)(n % divisor));
+        }
+    }
+
+    // The 32-bit overloads only see dividends that fit
+    if(n <= UINT32_MAX) {
+        uint32_t m = (uint32_t)n;
+        ++comparisons;
+        if(divider.quotient(m) != m / divisor || divider.remainder(m) != m % divisor) {
+            if(++failures <= 10) {
+                fprintf(stderr, "32-bit %u / %u: quotient %u remainder %u instead of %u and %u\n", m, divisor,
+                        divider.quotient(m), divider.remainder(m), m / divisor, m % divisor);
+            }
+        }
+    }
+}
+
+// Every dividend up to 2^16 and around 2^32 and 2^64, where rounding errors of the multipliers show first
+static void checkRanges(const FastDivider& divider) {
+    const uint64_t span = 1 << 16;
+    for(uint64_t n = 0; n <= span; ++n) {
+        check(divider, n);
+        check(divider, ((uint64_t)1 << 32) - 1 - n);
+        check(divider, ((uint64_t)1 << 32) + n);
+        check(divider, UINT64_MAX - n);
+    }
+}
+
+int main() {
+    std::vector<uint32_t> divisors = {1, 3, 5, 6, 7, 12, 20, 24, 96, 100, 384, 641, 1000, 12345, 65535,
+                                      0x80000001u, 0xFFFFFFFEu, 0xFFFFFFFFu};
+    for(unsigned bit = 1; bit < 32; ++bit) {
+        divisors.push_back(1u << bit);
+    }
+    std::mt19937_64 random(42);
+    for(unsigned i = 0; i < 64; ++i) {
+        // Random divisors of every magnitude
+        divisors.push_back(std::max<uint32_t>((uint32_t)(random() >> (32 + i % 32)), 1));
+    }
+
+    for(uint32_t divisor : divisors) {
+        FastDivider divider(divisor);
+        checkRanges(divider);
+        for(unsigned i = 0; i < 100000; ++i) {
+            check(divider, random() >> (i % 64));
+        }
+    }
+
+    // Exhaustive over small divisors and dividends
+    for(uint32_t divisor = 1; divisor <= 1024; ++divisor) {
+        FastDivider divider(divisor);
+        for(uint64_t n = 0; n < 4096; ++n) {
+            check(divider, n);
+        }
+    }
+
+    printf("fast_divider: %zu of %zu comparisons failed\n", failures, comparisons);
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
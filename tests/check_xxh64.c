@@ -0,0 +1,50 @@
+/* Checks the XXH64 of the result cache against the sanity vectors of the reference
+ * implementation (xxhsum), which cover every tail length and a non-zero seed.
+ * The hash is static, so the translation unit is included. */
+#include "../src/result_cache.c"
+
+#define SANITY_BUFFER_SIZE 222
+#define PRIME32 2654435761U
+// Multiplier of the byte generator of xxhsum, close to but not PRIME64_1
+#define GENERATOR_PRIME 11400714785074694797ULL
+
+struct Vector {
+    size_t length;
+    uint64_t seed;
+    uint64_t hash;
+};
+
+static const struct Vector vectors[] = {
+    {0, 0, 0xEF46DB3751D8E999ULL},        // empty
+    {0, PRIME32, 0xAC75FDA2929B17EFULL},
+    {1, 0, 0xE934A84ADB052768ULL},        // single bytes only
+    {1, PRIME32, 0x5014607643A9B4C3ULL},
+    {4, 0, 0x9136A0DCA57457EEULL},        // one 4 byte word
+    {14, 0, 0x8282DCC4994E35C8ULL},       // 8 byte word, 4 byte word and bytes
+    {14, PRIME32, 0xC3BD6BF63DEB6DF0ULL},
+    {222, 0, 0xB641AE8CB691C174ULL},      // 32 byte stripes and every tail
+    {222, PRIME32, 0x20CB8AB7AE10C14AULL},
+};
+
+int main(void) {
+    // Same pseudo-random bytes as the reference test
+    uint8_t buffer[SANITY_BUFFER_SIZE];
+    uint64_t generator = PRIME32;
+    for (size_t i = 0; i < SANITY_BUFFER_SIZE; i++) {
+        buffer[i] = (uint8_t)(generator >> 56);
+        generator *= GENERATOR_PRIME;
+    }
+
+    int failures = 0;
+    for (size_t i = 0; i < sizeof(vectors) / sizeof(vectors[0]); i++) {
+        uint64_t hash = xxh64(buffer, vectors[i].length, vectors[i].seed);
+        if (hash != vectors[i].hash) {
+            fprintf(stderr, "XXH64 of %zu bytes with seed %llu is 0x%016llX instead of 0x%016llX\n",
+                    vectors[i].length, (unsigned long long)vectors[i].seed, (unsigned long long)hash,
+                    (unsigned long long)vectors[i].hash);
+            failures++;
+        }
+    }
+    printf("xxh64: %d of %zu vectors failed\n", failures, sizeof(vectors) / sizeof(vectors[0]));
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}